@@ -0,0 +1,150 @@
+#include "bitbase.hpp"
+
+namespace ChessProject {
+
+const std::string Bitbase::Names[NUM_MATERIALS] = { "kqk", "krk", "kpk", "kbnk" };
+const Piece::Type Bitbase::Pieces[NUM_MATERIALS][MAX_BITBASE_PIECES - 2] = {
+	{ Piece::QUEEN, Piece::NONE },
+	{ Piece::ROOK, Piece::NONE },
+	{ Piece::PAWN, Piece::NONE },
+	{ Piece::BISHOP, Piece::KNIGHT }
+};
+const unsigned char Bitbase::Draw;
+const unsigned char Bitbase::Illegal;
+const position Bitbase::TriangleSquares[NUM_TRIANGLE_SQUARES] = { 0, 8, 9, 16, 17, 18, 24, 25, 26, 27 };
+MappedFile Bitbase::Tables[NUM_MATERIALS];
+bool Bitbase::Loaded = false;
+
+int Bitbase::NumStrongPieces(Material material) {
+	int numPieces = 1;
+	while (numPieces - 1 < MAX_BITBASE_PIECES - 2 && Pieces[material][numPieces - 1] != Piece::NONE) numPieces++;
+	return numPieces;
+}
+
+int Bitbase::Size(Material material) {
+	// The side to move, the strong king or pawn, and every other piece anywhere on the board.
+	int size = 2 * (material == KPK ? 24 : NUM_TRIANGLE_SQUARES);
+	for (int i = 1; i < NumStrongPieces(material) + 1; i++) size *= BOARDSIZE;
+	return size;
+}
+
+int Bitbase::Index(Material material, bool strongToMove, const position *squares) {
+	position mirrored[MAX_BITBASE_PIECES];
+	int numPieces = NumStrongPieces(material) + 1;
+	for (int i = 0; i < numPieces; i++) mirrored[i] = squares[i];
+	Mirror(material, mirrored);
+	int index = strongToMove ? 0 : 1;
+	if (material == KPK) {
+		// The pawn is on files a-d of ranks 2-7, and the kings can be anywhere.
+		position pawn = mirrored[1];
+		index = index * 24 + (Position::Rank(pawn) - 1) * 4 + Position::File(pawn);
+		index = index * BOARDSIZE + mirrored[0];
+		return index * BOARDSIZE + mirrored[2];
+	}
+	index = index * NUM_TRIANGLE_SQUARES + TriangleIndex(mirrored[0]);
+	for (int i = 1; i < numPieces; i++) index = index * BOARDSIZE + mirrored[i];
+	return index;
+}
+
+void Bitbase::Decode(Material material, int index, bool &strongToMove, position *squares) {
+	int numPieces = NumStrongPieces(material) + 1;
+	if (material == KPK) {
+		squares[2] = index % BOARDSIZE;
+		index /= BOARDSIZE;
+		squares[0] = index % BOARDSIZE;
+		index /= BOARDSIZE;
+		squares[1] = Position::ToInt(index % 4, (index % 24) / 4 + 1);
+		strongToMove = index / 24 == 0;
+		return;
+	}
+	for (int i = numPieces - 1; i > 0; i--) {
+		squares[i] = index % BOARDSIZE;
+		index /= BOARDSIZE;
+	}
+	squares[0] = TriangleSquares[index % NUM_TRIANGLE_SQUARES];
+	strongToMove = index / NUM_TRIANGLE_SQUARES == 0;
+}
+
+std::string Bitbase::Path(const std::string &directory, Material material) {
+	return directory + "/" + Names[material] + ".bb";
+}
+
+int Bitbase::Load(const std::string &directory) {
+	int numLoaded = 0;
+	for (int material = 0; material < NUM_MATERIALS; material++) {
+		MappedFile &table = Tables[material];
+		// A table of the wrong size is from some other version of the generator.
+		if (table.open(Path(directory, (Material)material)) && table.size() != (std::size_t)Size((Material)material)) table.close();
+		if (table.isOpen()) numLoaded++;
+	}
+	Loaded = numLoaded > 0;
+	return numLoaded;
+}
+
+bool Bitbase::Probe(const Board *board, const GameInfo *gameInfo, int &score) {
+	if (!Loaded) return false;
+	int numPieces = __builtin_popcountll(board->getOccupied());
+	if (numPieces < 3 || numPieces > MAX_BITBASE_PIECES) return false;
+	// The weak side only has its king.
+	Piece::Color strong = __builtin_popcountll(board->getOccupied(Piece::WHITE)) > 1 ? Piece::WHITE : Piece::BLACK;
+	Piece::Color weak = (Piece::Color)!strong;
+	if (__builtin_popcountll(board->getOccupied(weak)) != 1) return false;
+	for (int material = 0; material < NUM_MATERIALS; material++) {
+		int numStrong = NumStrongPieces((Material)material);
+		if (!Tables[material].isOpen() || numStrong != numPieces - 1) continue;
+		position squares[MAX_BITBASE_PIECES];
+		squares[0] = __builtin_ctzll(board->getPieces(strong, Piece::KING));
+		bool match = true;
+		for (int i = 1; i < numStrong && match; i++) {
+			bitboard64 pieces = board->getPieces(strong, Pieces[material][i - 1]);
+			match = __builtin_popcountll(pieces) == 1;
+			if (match) squares[i] = __builtin_ctzll(pieces);
+		}
+		if (!match) continue;
+		squares[numStrong] = __builtin_ctzll(board->getPieces(weak, Piece::KING));
+		// Black's pieces are seen from the other side of the board.
+		if (strong == Piece::BLACK) {
+			for (int i = 0; i <= numStrong; i++) squares[i] ^= 56;
+		}
+		bool strongToMove = gameInfo->turn == strong;
+		unsigned char value = Tables[material].data()[Index((Material)material, strongToMove, squares)];
+		if (value == Illegal) return false;
+		score = Score(value, strongToMove);
+		return true;
+	}
+	return false;
+}
+
+int Bitbase::Score(unsigned char value, bool strongToMove) {
+	if (value == Draw) return 0;
+	int score = WinScore - (value - 1);
+	return strongToMove ? score : -score;
+}
+
+int Bitbase::TriangleIndex(position pos) {
+	// Rank r of the triangle holds r + 1 squares, after the r * (r + 1) / 2 squares of the ranks below it.
+	int rank = Position::Rank(pos);
+	return rank * (rank + 1) / 2 + Position::File(pos);
+}
+
+void Bitbase::Mirror(Material material, position *squares) {
+	int numPieces = NumStrongPieces(material) + 1;
+	if (material == KPK) {
+		if (Position::File(squares[1]) > 3) {
+			for (int i = 0; i < numPieces; i++) squares[i] ^= 7;
+		}
+		return;
+	}
+	if (Position::File(squares[0]) > 3) {
+		for (int i = 0; i < numPieces; i++) squares[i] ^= 7;
+	}
+	if (Position::Rank(squares[0]) > 3) {
+		for (int i = 0; i < numPieces; i++) squares[i] ^= 56;
+	}
+	// Flip along the a1-h8 diagonal, swapping files and ranks.
+	if (Position::File(squares[0]) > Position::Rank(squares[0])) {
+		for (int i = 0; i < numPieces; i++) squares[i] = Position::ToInt(Position::Rank(squares[i]), Position::File(squares[i]));
+	}
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "gameinfo.hpp"
+#include "mappedfile.hpp"
+#include "piece.hpp"
+#include "position.hpp"
+
+// The most pieces in any bitbase, including both kings.
+#define MAX_BITBASE_PIECES 4
+
+namespace ChessProject {
+
+// Bitbases hold the result of every position of a few endgames in which one side has a king and one or two pieces, and the other only has
+//a king. They are generated by the bitbase tool, working backwards from the checkmates (retrograde analysis), and probed by the search
+//once the material on the board matches, which replaces the whole subtree of such a position with one lookup.
+// Each table is a file of one byte per position. 0 is a draw, 255 an illegal position, and any other value is one more than the number of
+//plies to checkmate with best play (distance to mate). Only the side with pieces can win, so whether it is a win or a loss depends on
+//which side is to move.
+// Positions are stored from the point of view of the strong side playing up the board, so the colors and ranks of a position with the
+//pieces on black are swapped before looking it up. Symmetry also shrinks the tables: without pawns, the board is mirrored so that the
+//strong king is in the a1-a4-d4 triangle, and with a pawn, so that the pawn is on files a-d.
+struct Bitbase {
+	// Tables are generated in this order, as a pawn can promote into the queen and rook endgames.
+	enum Material {
+		KQK,
+		KRK,
+		KPK,
+		KBNK,
+		NUM_MATERIALS
+	};
+	static const std::string Names[NUM_MATERIALS];
+	// The strong side's pieces other than the king, with Piece::NONE after the last.
+	static const Piece::Type Pieces[NUM_MATERIALS][MAX_BITBASE_PIECES - 2];
+	static const unsigned char Draw = 0;
+	static const unsigned char Illegal = 255;
+	// A position won in n plies scores WinScore - n for the side to move. This is below the score of a checkmate found by the search, so
+	//that a real checkmate is always preferred.
+	static const int WinScore = 50000;
+	// Returns the number of pieces the strong side has, including its king.
+	static int NumStrongPieces(Material material);
+	// Returns the number of positions in a table.
+	static int Size(Material material);
+	// Returns the index of a position. The squares are the strong king, the strong side's pieces in the order of Pieces, and the weak king,
+	//from the strong side's point of view. They are mirrored into place first.
+	static int Index(Material material, bool strongToMove, const position *squares);
+	// Sets the side to move and squares of the position at an index. The inverse of Index.
+	static void Decode(Material material, int index, bool &strongToMove, position *squares);
+	// Returns the file name of a table in a directory.
+	static std::string Path(const std::string &directory, Material material);
+	// Maps every table found in a directory into memory. Returns the number of tables loaded.
+	static int Load(const std::string &directory);
+	// If the position's material matches a loaded table, stores its score for the side to move (0 for a draw, otherwise WinScore less the
+	//plies to mate, negated for the losing side) and returns true.
+	static bool Probe(const Board *board, const GameInfo *gameInfo, int &score);
+	// Returns the score of a table entry for the side to move.
+	static int Score(unsigned char value, bool strongToMove);
+private:
+	static MappedFile Tables[NUM_MATERIALS];
+	// Set once any table is loaded, so that probing costs nothing otherwise.
+	static bool Loaded;
+	// The squares of the a1-a4-d4 triangle, rank by rank.
+	static const int NUM_TRIANGLE_SQUARES = 10;
+	static const position TriangleSquares[NUM_TRIANGLE_SQUARES];
+	// Returns the index of a square of the triangle in TriangleSquares.
+	static int TriangleIndex(position pos);
+	// Mirrors the squares of a position so that the strong king is in the triangle, or the pawn is on files a-d.
+	static void Mirror(Material material, position *squares);
+};
+
+}
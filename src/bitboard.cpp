@@ -2,51 +2,158 @@
 
 namespace ChessProject {
 
-bitboard Bitboard::PassedPawnEval[NUM_COLORS][BOARDSIZE];
-bitboard Bitboard::IsolatedPawnEval[BOARDSIZE];
-bitboard Bitboard::File[NUM_FILES];
+const bitboard64 Bitboard::FileA;
+const bitboard64 Bitboard::FileH;
+const bitboard64 Bitboard::Rank1;
+Bitboard::Magic Bitboard::BishopMagics[BOARDSIZE];
+Bitboard::Magic Bitboard::RookMagics[BOARDSIZE];
+bitboard64 Bitboard::BishopTable[5248];
+bitboard64 Bitboard::RookTable[102400];
 
-void Bitboard::Precalculate() {
-	// Passed pawn evals and pawn attack offsets.
-	for (int color = 0; color < NUM_COLORS; color++) {
-		int upOffset = Buffer::PawnOffset[color];
-		for (position pos = 0; pos < BOARDSIZE; pos++) {
-			for (int i = -1; i <= 1; i++) {
-				for (int j = 1, p = Buffer::Board[Buffer::Coords[pos] + (upOffset * j) + i];
-					 p > 0; j++, p = Buffer::Board[Buffer::Coords[pos] + (upOffset * j) + i]) {
-					PassedPawnEval[color][pos][p] = true;
-				}
-			}
+constexpr SquareTable<bitboard64> Bitboard::StepAttacks(Piece::Type type) {
+	SquareTable<bitboard64> table = { };
+	for (position pos = 0; pos < BOARDSIZE; pos++) {
+		for (int i = 0; i < Buffer::NumOffsets[type]; i++) {
+			position to = Buffer::Board[Buffer::Coords[pos] + Buffer::Offset[type][i]];
+			if (to >= 0) table.squares[pos] |= Square(to);
 		}
 	}
-	// Isolated pawn evals.
+	return table;
+}
+
+constexpr SquareTable<bitboard64> Bitboard::PawnStepAttacks(Piece::Color color) {
+	SquareTable<bitboard64> table = { };
 	for (position pos = 0; pos < BOARDSIZE; pos++) {
-		for (int relFile = -1; relFile <= 1; relFile += 2) {
-			for (int relRank = Buffer::S; relRank <= Buffer::N; relRank += Buffer::N) {
-				position p = Buffer::Board[Buffer::Coords[pos] + relFile + relRank];
-				if (p > 0) IsolatedPawnEval[pos][p] = true;
+		for (int i = -1; i <= 1; i += 2) {
+			position to = Buffer::Board[Buffer::Coords[pos] + Buffer::PawnOffset[color] + i];
+			if (to >= 0) table.squares[pos] |= Square(to);
+		}
+	}
+	return table;
+}
+
+constexpr SquareTable<SquareTable<bitboard64> > Bitboard::LineTable(bool whole) {
+	SquareTable<SquareTable<bitboard64> > table = { };
+	for (position from = 0; from < BOARDSIZE; from++) {
+		// Walk out from the square in every queen direction. Each square reached shares a line with it.
+		for (int i = 0; i < Buffer::NumOffsets[Piece::QUEEN]; i++) {
+			int offset = Buffer::Offset[Piece::QUEEN][i];
+			bitboard64 line = Square(from);
+			for (position to = Buffer::Board[Buffer::Coords[from] + offset]; to >= 0; to = Buffer::Board[Buffer::Coords[to] + offset]) {
+				line |= Square(to);
+			}
+			for (position to = Buffer::Board[Buffer::Coords[from] - offset]; to >= 0; to = Buffer::Board[Buffer::Coords[to] - offset]) {
+				line |= Square(to);
+			}
+			bitboard64 between = 0;
+			for (position to = Buffer::Board[Buffer::Coords[from] + offset]; to >= 0; to = Buffer::Board[Buffer::Coords[to] + offset]) {
+				table.squares[from].squares[to] = whole ? line : between;
+				between |= Square(to);
 			}
 		}
 	}
-	// File bitboards.
-	for (int file = 0; file < NUM_FILES; file++) {
-		for (int rank = 0; rank < NUM_RANKS; rank++) {
-			File[file][Position::ToInt(file, rank)] = true;
+	return table;
+}
+
+constexpr SquareTable<bitboard64> Bitboard::KnightAttacks = Bitboard::StepAttacks(Piece::KNIGHT);
+constexpr SquareTable<bitboard64> Bitboard::KingAttacks = Bitboard::StepAttacks(Piece::KING);
+constexpr SquareTable<bitboard64> Bitboard::PawnAttacks[NUM_COLORS] = {
+	Bitboard::PawnStepAttacks(Piece::WHITE),
+	Bitboard::PawnStepAttacks(Piece::BLACK)
+};
+constexpr SquareTable<SquareTable<bitboard64> > Bitboard::Between = Bitboard::LineTable(false);
+constexpr SquareTable<SquareTable<bitboard64> > Bitboard::Line = Bitboard::LineTable(true);
+
+const int Bitboard::BishopDirections[4][2] = { { 1, 1 }, { 1, -1 }, { -1, -1 }, { -1, 1 } };
+const int Bitboard::RookDirections[4][2] = { { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 } };
+
+void Bitboard::Precalculate() {
+	InitMagics(BishopMagics, BishopTable, BishopDirections);
+	InitMagics(RookMagics, RookTable, RookDirections);
+}
+
+void Bitboard::InitMagics(Magic *magics, bitboard64 *table, const int directions[4][2]) {
+	// xorshift64 pseudo-random number generator with a fixed seed, so that the same magics are found every run.
+	static uint64_t seed = 0x2545F4914F6CDD1DULL;
+	bitboard64 occupancies[4096], attacks[4096];
+	bitboard64 *squareTable = table;
+	for (position pos = 0; pos < BOARDSIZE; pos++) {
+		Magic &m = magics[pos];
+		// The relevant mask is every square a slider could be blocked on. The last square in each direction never blocks anything behind it.
+		m.mask = 0;
+		for (int d = 0; d < 4; d++) {
+			int file = Position::File(pos) + directions[d][0];
+			int rank = Position::Rank(pos) + directions[d][1];
+			while (file + directions[d][0] >= 0 && file + directions[d][0] < NUM_FILES &&
+				   rank + directions[d][1] >= 0 && rank + directions[d][1] < NUM_RANKS) {
+				m.mask |= Square(Position::ToInt(file, rank));
+				file += directions[d][0];
+				rank += directions[d][1];
+			}
 		}
+		int bits = __builtin_popcountll(m.mask);
+		int size = 1 << bits;
+		m.shift = 64 - bits;
+		m.attacks = squareTable;
+		squareTable += size;
+		// Enumerate every subset of the relevant mask (the Carry-Rippler trick).
+		bitboard64 occupied = 0;
+		for (int i = 0; i < size; i++) {
+			occupancies[i] = occupied;
+			attacks[i] = SlidingAttacks(pos, occupied, directions);
+			occupied = (occupied - m.mask) & m.mask;
+		}
+#ifdef __BMI2__
+		m.magic = 0;
+		for (int i = 0; i < size; i++) m.attacks[m.index(occupancies[i])] = attacks[i];
+#else
+		// Try sparse random numbers until one maps every subset to an index without two different attack sets colliding.
+		int tried[4096] = { 0 };
+		for (int attempt = 1; ; attempt++) {
+			bitboard64 magic = ~(bitboard64)0;
+			for (int r = 0; r < 3; r++) {
+				seed ^= seed >> 12;
+				seed ^= seed << 25;
+				seed ^= seed >> 27;
+				magic &= seed * 0x2545F4914F6CDD1DULL;
+			}
+			if (__builtin_popcountll((m.mask * magic) >> 56) < 6) continue;
+			m.magic = magic;
+			bool collision = false;
+			for (int i = 0; i < size && !collision; i++) {
+				unsigned int index = m.index(occupancies[i]);
+				if (tried[index] != attempt) {
+					tried[index] = attempt;
+					m.attacks[index] = attacks[i];
+				} else if (m.attacks[index] != attacks[i]) {
+					collision = true;
+				}
+			}
+			if (!collision) break;
+		}
+#endif
 	}
 }
 
-bitboard Bitboard::GetPawnAttacks(Piece::Color color, bitboard pawns) {
-	if (color == Piece::WHITE) pawns <<= NUM_FILES;
-	else pawns >>= NUM_FILES;
-	pawns = ((pawns & ~File[0]) >> 1) | ((pawns & ~File[NUM_FILES - 1]) << 1);
-	return pawns;
+bitboard64 Bitboard::SlidingAttacks(position pos, bitboard64 occupied, const int directions[4][2]) {
+	bitboard64 attacks = 0;
+	for (int d = 0; d < 4; d++) {
+		int file = Position::File(pos) + directions[d][0];
+		int rank = Position::Rank(pos) + directions[d][1];
+		while (file >= 0 && file < NUM_FILES && rank >= 0 && rank < NUM_RANKS) {
+			attacks |= Square(Position::ToInt(file, rank));
+			if (occupied & Square(Position::ToInt(file, rank))) break;
+			file += directions[d][0];
+			rank += directions[d][1];
+		}
+	}
+	return attacks;
 }
 
-void Bitboard::Print(bitboard bboard) {
+void Bitboard::Print(bitboard64 bboard) {
 	for (int rank = NUM_RANKS - 1; rank >= 0; rank--) {
 		for (int file = 0; file < NUM_FILES; file++) {
-			std::cout << bboard[Position::ToInt(file, rank)] << " ";
+			std::cout << ((bboard >> Position::ToInt(file, rank)) & 1) << " ";
 		}
 		std::cout << std::endl;
 	}
@@ -1,31 +1,140 @@
 #pragma once
 
-#include <bitset>
 #include <iostream>
+#include <stdint.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 #include "buffer.hpp"
 #include "piece.hpp"
 #include "position.hpp"
 
 namespace ChessProject {
 
-typedef std::bitset<BOARDSIZE> bitboard;
+// A raw 64-bit word with one bit per square, a1 being the lowest bit and h8 the highest. Whole sets of squares are moved and combined with a
+//few shifts and masks on a single machine word.
+typedef uint64_t bitboard64;
+
+// A table with one entry for every square. Unlike a plain array it can be returned from a function, so whole tables can be generated by
+//constexpr functions at compile time and stored in read only memory.
+template <typename T>
+struct SquareTable {
+	T squares[BOARDSIZE];
+	constexpr const T &operator[](position pos) const {
+		return squares[pos];
+	}
+};
 
 struct Bitboard {
-	// A precalculated bitboard that sets all the bits that need to be unoccupied
-	//by an enemy pawn in order for a pawn at a given position to be "passed."
-	static bitboard PassedPawnEval[NUM_COLORS][BOARDSIZE];
-	// This bitboard sets all the bits that need to be unoccupied by an allied pawn
-	//in order for a pawn at a given position to be "isolated."
-	static bitboard IsolatedPawnEval[BOARDSIZE];
-	// This is a bitboard with all the bits on a given file set.
-	// Used for doubled pawn evaluation.
-	static bitboard File[NUM_FILES];
-
-	// Precalculates static bitboards. Must be executed before any pawn evaluation.
+	// The squares of the a and h files. Shifting a set one file sideways masks out the squares that would wrap around to the other edge.
+	static const bitboard64 FileA = 0x0101010101010101ULL;
+	static const bitboard64 FileH = 0x8080808080808080ULL;
+	// The squares of the first rank.
+	static const bitboard64 Rank1 = 0xffULL;
+
+	// Squares attacked by a knight or king on a given square.
+	static const SquareTable<bitboard64> KnightAttacks;
+	static const SquareTable<bitboard64> KingAttacks;
+	// Squares attacked by a pawn of a given color on a given square.
+	static const SquareTable<bitboard64> PawnAttacks[NUM_COLORS];
+	// If two squares share a rank, file or diagonal, Between holds the squares strictly between them and Line holds the whole line through
+	//both of them. Otherwise both are empty. Used to find pins and the squares that block a check.
+	static const SquareTable<SquareTable<bitboard64> > Between;
+	static const SquareTable<SquareTable<bitboard64> > Line;
+
+	// Finds the magic numbers and fills the slider attack tables. Must be executed before any move generation. The other tables are all
+	//generated at compile time.
 	static void Precalculate();
-	// Returns a bitboard with spaces that can be attacked by a pawn set.
-	static bitboard GetPawnAttacks(Piece::Color color, bitboard pawns);
-	static void Print(bitboard bboard);
+	static void Print(bitboard64 bboard);
+	// Returns the squares attacked by a bishop or rook on the given square. Attacks stop at (and include) the first occupied square in each
+	//direction, whatever its color.
+	static bitboard64 BishopAttacks(position pos, bitboard64 occupied) {
+		return BishopMagics[pos].attacks[BishopMagics[pos].index(occupied)];
+	}
+	static bitboard64 RookAttacks(position pos, bitboard64 occupied) {
+		return RookMagics[pos].attacks[RookMagics[pos].index(occupied)];
+	}
+	static constexpr bitboard64 Square(position pos) {
+		return (bitboard64)1 << pos;
+	}
+	// Returns the squares of a given file.
+	static bitboard64 FileMask(int file) {
+		return FileA << file;
+	}
+	// Moves every square of the set one file towards the h file or the a file. Squares that would leave the board are dropped.
+	static bitboard64 East(bitboard64 bboard) {
+		return (bboard << 1) & ~FileA;
+	}
+	static bitboard64 West(bitboard64 bboard) {
+		return (bboard >> 1) & ~FileH;
+	}
+	// Moves every square of the set one rank forward, as seen by the given color.
+	static bitboard64 Forward(Piece::Color color, bitboard64 bboard) {
+		return color == Piece::WHITE ? bboard << NUM_FILES : bboard >> NUM_FILES;
+	}
+	// Smears every square of the set forward to the edge of the board, as seen by the given color. The front fill of a color's pawns shifted
+	//one rank forward is their front span - the squares they still have to cross to promote.
+	static bitboard64 FrontFill(Piece::Color color, bitboard64 bboard) {
+		if (color == Piece::WHITE) {
+			bboard |= bboard << 8;
+			bboard |= bboard << 16;
+			bboard |= bboard << 32;
+		} else {
+			bboard |= bboard >> 8;
+			bboard |= bboard >> 16;
+			bboard |= bboard >> 32;
+		}
+		return bboard;
+	}
+	// Returns every square on a file that holds at least one square of the set.
+	static bitboard64 FileFill(bitboard64 bboard) {
+		return FrontFill(Piece::WHITE, bboard) | FrontFill(Piece::BLACK, bboard);
+	}
+	// Returns the squares attacked by a set of pawns of the given color.
+	static bitboard64 GetPawnAttacks(Piece::Color color, bitboard64 pawns) {
+		pawns = Forward(color, pawns);
+		return East(pawns) | West(pawns);
+	}
+	// Removes the lowest set square from the bitboard and returns it.
+	static position PopFirst(bitboard64 &bboard) {
+		position pos = __builtin_ctzll(bboard);
+		bboard &= bboard - 1;
+		return pos;
+	}
+private:
+	// Generate the constant tables from the buffer board offsets. Only evaluated at compile time.
+	static constexpr SquareTable<bitboard64> StepAttacks(Piece::Type type);
+	static constexpr SquareTable<bitboard64> PawnStepAttacks(Piece::Color color);
+	// Generates Line if whole is true, and Between if it isn't.
+	static constexpr SquareTable<SquareTable<bitboard64> > LineTable(bool whole);
+	// Slider attacks are looked up with "magic" bitboards. Only the occupancy of the squares that can block a slider (the relevant mask) affects
+	//its attacks. Multiplying the relevant occupancy by a magic number gathers those bits into the top of the word, giving a unique index into a
+	//table of attacks. If the CPU has the BMI2 instruction set, the PEXT instruction does the same gathering directly.
+	struct Magic {
+		bitboard64 mask;
+		bitboard64 magic;
+		int shift;
+		bitboard64 *attacks;
+		unsigned int index(bitboard64 occupied) const {
+#ifdef __BMI2__
+			return (unsigned int)_pext_u64(occupied, mask);
+#else
+			return (unsigned int)(((occupied & mask) * magic) >> shift);
+#endif
+		}
+	};
+	static Magic BishopMagics[BOARDSIZE];
+	static Magic RookMagics[BOARDSIZE];
+	// Every square's attacks are stored consecutively in one table per slider type.
+	static bitboard64 BishopTable[5248];
+	static bitboard64 RookTable[102400];
+	// Directions that bishops and rooks move in, as (file, rank) steps.
+	static const int BishopDirections[4][2];
+	static const int RookDirections[4][2];
+	// Finds magic numbers and fills the attack table for one slider type.
+	static void InitMagics(Magic *magics, bitboard64 *table, const int directions[4][2]);
+	// Calculates slider attacks by walking each direction one square at a time. Only used to fill the attack tables.
+	static bitboard64 SlidingAttacks(position pos, bitboard64 occupied, const int directions[4][2]);
 };
 
 }
@@ -2,7 +2,10 @@
 
 namespace ChessProject {
 
-Board::~Board() {
+bool Board::TaperedEval = true;
+thread_local PawnTable Board::PawnHash;
+
+Board::Board() {
 	cleanup();
 }
 
@@ -11,9 +14,8 @@ void Board::init() {
 	// Set up board to starting positions.
 	for (int color = 0; color < NUM_COLORS; color++) {
 		for (int type = 0; type < NUM_PIECE_TYPES; type++) {
-			for (positionlist::iterator it = Piece::InitialSetup[color][type].begin();
-				 it != Piece::InitialSetup[color][type].end(); it++) {
-				addPiece((Piece::Color)color, (Piece::Type)type, *it);
+			for (bitboard64 squares = Piece::InitialSetup[color][type]; squares; ) {
+				addPiece((Piece::Color)color, (Piece::Type)type, Bitboard::PopFirst(squares));
 			}
 		}
 	}
@@ -22,185 +24,260 @@ void Board::init() {
 void Board::cleanup() {
 	// Initialise board to null values.
 	for (position pos = 0; pos < BOARDSIZE; pos++)
-		internalBoard[pos] = 0;
+		internalBoard[pos] = Piece();
+	hash = 0;
+	phase = 0;
+	attacksKnown = 0;
 	for (int color = 0; color < NUM_COLORS; color++) {
-		king[color] = 0;
-		pawnStructure[color].reset();
-		// Free piece pointers.
-		for (PieceList::iterator pieceItr = pieceList[color].begin(); pieceItr != pieceList[color].end(); pieceItr++) {
-			delete *pieceItr;
-		}
-		pieceList[color].clear();
+		king[color] = -1;
+		material[color] = 0;
+		for (int gamePhase = 0; gamePhase < NUM_GAME_PHASES; gamePhase++) positionBonus[color][gamePhase] = 0;
+		occupied[color] = 0;
+		for (int type = 0; type < NUM_PIECE_TYPES; type++) pieces[color][type] = 0;
 	}
-	// Free captured pieces.
-	for (PieceList::iterator pieceItr = captured.begin(); pieceItr != captured.end(); pieceItr++) {
-		delete *pieceItr;
-	}
-	captured.clear();
 }
 
-int Board::materialEval(Piece::Color color) {
-	int eval = 0;
+int Board::materialEval(Piece::Color color) const {
+	Piece::Color enemy = (Piece::Color)!color;
+	int eval = material[color] - material[enemy];
+	int middleGameBonus = positionBonus[color][Piece::MIDDLEGAME] - positionBonus[enemy][Piece::MIDDLEGAME];
+	int endGameBonus = positionBonus[color][Piece::ENDGAME] - positionBonus[enemy][Piece::ENDGAME];
+	if (TaperedEval) {
+		// Promotions can take the phase above its starting value.
+		int gamePhase = std::min(phase, Piece::MaxPhase);
+		eval += (middleGameBonus * gamePhase + endGameBonus * (Piece::MaxPhase - gamePhase)) / Piece::MaxPhase;
+	} else {
+		// As before tapering, the king is left out of the piece square evaluation in the endgame.
+		eval += middleGameBonus;
+		if (isEndGame() && king[color] >= 0) eval -= Piece::GetPositionBonus(color, Piece::KING, king[color]);
+		if (isEndGame() && king[enemy] >= 0) eval += Piece::GetPositionBonus(enemy, Piece::KING, king[enemy]);
+	}
 	for (int colorIt = 0; colorIt < NUM_COLORS; colorIt++) {
 		int colorWeighting = color == colorIt ? 1 : -1;
-		int numBishops = 0;
-		for (PieceList::iterator pieceItr = pieceList[colorIt].begin(); pieceItr != pieceList[colorIt].end(); pieceItr++) {
-			Piece *piece = *pieceItr;
-			eval += Piece::MaterialWorth[piece->type] * colorWeighting;
-			// The king's piece table is a cautious one. If the board is in end game, disregard it.
-			if (piece->type != Piece::KING || !isEndGame()) {
-				eval += Piece::GetPositionBonus((Piece::Color)colorIt, piece->type, piece->pos) * colorWeighting;
-			}
-			// Add bonus for rook on an open or semi-open file.
-			if (piece->type == Piece::ROOK) {
-				if ((pawnStructure[colorIt] & Bitboard::File[Position::File(piece->pos)]).none())
-					eval += Piece::RookOnOpenFile * colorWeighting;
-			} else if (piece->type == Piece::BISHOP) {
-				numBishops++;
-			}
+		// Add bonus for rook on an open or semi-open file.
+		bitboard64 rooks = pieces[colorIt][Piece::ROOK];
+		while (rooks) {
+			position pos = Bitboard::PopFirst(rooks);
+			if (!(pieces[colorIt][Piece::PAWN] & Bitboard::FileMask(Position::File(pos)))) eval += Piece::RookOnOpenFile * colorWeighting;
 		}
 		// Apply a bonus for having both (or more) bishops.
-		if (numBishops > 1) eval += Piece::BothBishopsBonus * colorWeighting;
+		if (__builtin_popcountll(pieces[colorIt][Piece::BISHOP]) > 1) eval += Piece::BothBishopsBonus * colorWeighting;
 	}
 	return eval;
 }
 
+int Board::getPhase() const {
+	return phase;
+}
+
 bool Board::insufficientMaterial() const {
-	bool existsKnight = false;
+	bitboard64 knights = 0, bishops = 0;
+	for (int colorIt = 0; colorIt < NUM_COLORS; colorIt++) {
+		if (pieces[colorIt][Piece::PAWN] || pieces[colorIt][Piece::QUEEN] || pieces[colorIt][Piece::ROOK]) return false;
+		knights |= pieces[colorIt][Piece::KNIGHT];
+		bishops |= pieces[colorIt][Piece::BISHOP];
+	}
+	// A knight is only considered insufficient material if it is the only piece that isn't a king.
+	if (knights) return !bishops && !(knights & (knights - 1));
+	// If there are bishops on both light and dark squares, there is not insufficient material.
 	bool existsLightBishop = false;
 	bool existsDarkBishop = false;
-	for (int colorIt = 0; colorIt < NUM_COLORS; colorIt++) {
-		for (PieceList::iterator pieceItr = pieceList[colorIt].begin(); pieceItr != pieceList[colorIt].end(); pieceItr++) {
-			Piece *piece = *pieceItr;
-			if (piece->type == Piece::PAWN || piece->type == Piece::QUEEN || piece->type == Piece::ROOK) return false;
-			if (piece->type == Piece::KNIGHT) {
-				// A knight is only considered insufficient material if it is the only piece that isn't a king.
-				if (existsKnight || existsLightBishop || existsDarkBishop) return false;
-				else existsKnight = true;
-			} else if (piece->type == Piece::BISHOP) {
-				if (Position::IsLightTile(piece->pos)) existsLightBishop = true;
-				else existsDarkBishop = true;
-				// If there are bishops on both even and odd squares, there is not insufficient material. A bishop and a knight
-				//or any non-minor piece is also not draw-worthy.
-				if ((existsLightBishop && existsDarkBishop) || existsKnight) return false;
-			}
-		}
+	while (bishops) {
+		if (Position::IsLightTile(Bitboard::PopFirst(bishops))) existsLightBishop = true;
+		else existsDarkBishop = true;
 	}
-	return true;
+	return !(existsLightBishop && existsDarkBishop);
 }
 
 bool Board::isEndGame() const {
 	// If there are 12 pieces or less, return true.
-	return (pieceList[Piece::WHITE].size() + pieceList[Piece::BLACK].size()) <= 12;
+	return __builtin_popcountll(getOccupied()) <= 12;
 }
 
-int Board::pawnEval(Piece::Color color) {
-	int passed = 0;
-	int isolated = 0;
-	int doubled = 0;
-	int backward = 0;
-	for (int colorIt = 0; colorIt < NUM_COLORS; colorIt++) {
-		int colorWeighting = (color == colorIt ? 1 : -1);
-		// Calculate number of backward pawns. If the space in front of a pawn is being attacked by an enemy pawn and not being defended by an ally pawn,
-		//the pawn is considered to be a backward pawn as it cannot advance without sacrificing itself.
-		bitboard advance = pawnStructure[colorIt];
-		if (colorIt == Piece::WHITE) advance <<= NUM_FILES;
-		else advance >>= NUM_FILES;
-		// Set backwardsPawns to those spaces ahead of pawns of this color that are being attacked by enemy pawns, but not by allied pawns.
-		bitboard backwardsPawns = advance & Bitboard::GetPawnAttacks((Piece::Color)!colorIt, pawnStructure[!colorIt]);
-		backwardsPawns &= ~Bitboard::GetPawnAttacks((Piece::Color)colorIt, pawnStructure[colorIt]);
-		backward += colorWeighting * backwardsPawns.count();
-		// Iterate over every pawn, determining whether or not they are isolated or passed.
-		for (PieceList::iterator pieceItr = pieceList[colorIt].begin(); pieceItr != pieceList[colorIt].end(); pieceItr++) {
-			Piece *piece  = *pieceItr;
-			if (piece->type != Piece::PAWN) continue;
-			if ((Bitboard::PassedPawnEval[colorIt][piece->pos] & pawnStructure[!colorIt]).none()) passed += colorWeighting;
-			if ((Bitboard::IsolatedPawnEval[piece->pos] & pawnStructure[colorIt]).none()) isolated += colorWeighting;
-		}
-		// Iterate over every file, determining the number of doubled pawns per file.
-		for (int file = 0; file < NUM_FILES; file++) {
-			int numPawns = (Bitboard::File[file] & pawnStructure[colorIt]).count();
-			if (numPawns > 0) doubled += (numPawns - 1) * colorWeighting;
-		}
+int Board::pawnEval(Piece::Color color) const {
+	bitboard64 whitePawns = pieces[Piece::WHITE][Piece::PAWN];
+	bitboard64 blackPawns = pieces[Piece::BLACK][Piece::PAWN];
+	bool endGame = isEndGame();
+	PawnTable::Entry entry;
+	if (!PawnHash.probe(whitePawns, blackPawns, endGame, entry)) {
+		entry.pawns[Piece::WHITE] = whitePawns;
+		entry.pawns[Piece::BLACK] = blackPawns;
+		entry.endGame = endGame;
+		evalPawnStructure(entry);
+		PawnHash.store(entry);
 	}
+	return color == Piece::WHITE ? entry.score : -entry.score;
+}
+
+void Board::evalPawnStructure(PawnTable::Entry &entry) const {
+	PawnFeatures features;
+	countPawnFeatures(features);
+	for (int colorIt = 0; colorIt < NUM_COLORS; colorIt++) entry.passed[colorIt] = features.passedPawns[colorIt];
 	// At the end game, a passed pawn is considered much more powerful.
-	if (isEndGame()) passed *= Piece::EndGamePassedPawnBonus;
-	else passed *= Piece::PassedPawnBonus;
-	isolated *= Piece::IsolatedPawnPenalty;
-	doubled *= Piece::DoubledPawnPenalty;
-	backward *= Piece::BackwardPawnPenalty;
-	return passed + isolated + doubled + backward;
+	entry.score = features.passed * (entry.endGame ? Piece::EndGamePassedPawnBonus : Piece::PassedPawnBonus) +
+				  features.isolated * Piece::IsolatedPawnPenalty + features.doubled * Piece::DoubledPawnPenalty +
+				  features.backward * Piece::BackwardPawnPenalty;
 }
 
+void Board::countPawnFeatures(PawnFeatures &features) const {
+	CountPawnFeatures(pieces[Piece::WHITE][Piece::PAWN], pieces[Piece::BLACK][Piece::PAWN], features);
+}
+
+const Board::PawnFeatureCounter Board::CountPawnFeatures = Board::SelectPawnFeatureCounter();
+
+Board::PawnFeatureCounter Board::SelectPawnFeatureCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+	// This can run before any other static initialisation, so the CPU features have to be detected explicitly.
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("popcnt") && __builtin_cpu_supports("bmi2")) return CountPawnFeaturesBmi2;
+	if (__builtin_cpu_supports("popcnt")) return CountPawnFeaturesPopcnt;
+#endif
+	return CountPawnFeaturesGeneric;
+}
+
+__attribute__((always_inline)) inline void Board::CountPawnFeaturesSetwise(bitboard64 whitePawns, bitboard64 blackPawns,
+																		  PawnFeatures &features) {
+	bitboard64 pawns[NUM_COLORS] = { whitePawns, blackPawns };
+	bitboard64 isolated[NUM_COLORS];
+	bitboard64 backward[NUM_COLORS];
+	int doubled[NUM_COLORS];
+	for (int colorIt = 0; colorIt < NUM_COLORS; colorIt++) {
+		Piece::Color color = (Piece::Color)colorIt;
+		bitboard64 own = pawns[color];
+		bitboard64 enemy = pawns[!color];
+		// A pawn is passed if no enemy pawn stands ahead of it on its own or an adjacent file. Every square behind an enemy pawn (from the
+		//enemy's point of view) on those three files is therefore one where a pawn of this color would not be passed.
+		bitboard64 enemySpan = Bitboard::FrontFill((Piece::Color)!color, Bitboard::Forward((Piece::Color)!color, enemy));
+		features.passedPawns[color] = own & ~(enemySpan | Bitboard::East(enemySpan) | Bitboard::West(enemySpan));
+		// A pawn is isolated if there is no allied pawn on an adjacent file, on its own rank or the ranks either side of it.
+		bitboard64 neighbours = Bitboard::East(own) | Bitboard::West(own);
+		neighbours |= Bitboard::Forward(Piece::WHITE, neighbours) | Bitboard::Forward(Piece::BLACK, neighbours);
+		isolated[color] = own & ~neighbours;
+		// Every pawn on a file after the first is a doubled pawn.
+		doubled[color] = __builtin_popcountll(own) - __builtin_popcountll(Bitboard::FileFill(own) & Bitboard::Rank1);
+		// If the space in front of a pawn is being attacked by an enemy pawn and not being defended by an ally pawn, the pawn is considered
+		//to be a backward pawn as it cannot advance without sacrificing itself.
+		backward[color] = Bitboard::Forward(color, own) & Bitboard::GetPawnAttacks((Piece::Color)!color, enemy) &
+						  ~Bitboard::GetPawnAttacks(color, own);
+	}
+	features.passed = __builtin_popcountll(features.passedPawns[Piece::WHITE]) - __builtin_popcountll(features.passedPawns[Piece::BLACK]);
+	features.isolated = __builtin_popcountll(isolated[Piece::WHITE]) - __builtin_popcountll(isolated[Piece::BLACK]);
+	features.doubled = doubled[Piece::WHITE] - doubled[Piece::BLACK];
+	features.backward = __builtin_popcountll(backward[Piece::WHITE]) - __builtin_popcountll(backward[Piece::BLACK]);
+}
+
+void Board::CountPawnFeaturesGeneric(bitboard64 whitePawns, bitboard64 blackPawns, PawnFeatures &features) {
+	CountPawnFeaturesSetwise(whitePawns, blackPawns, features);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Compiled with the POPCNT instruction, instead of the table lookups the compiler otherwise falls back on for __builtin_popcountll.
+__attribute__((target("popcnt"))) void Board::CountPawnFeaturesPopcnt(bitboard64 whitePawns, bitboard64 blackPawns,
+																	  PawnFeatures &features) {
+	CountPawnFeaturesSetwise(whitePawns, blackPawns, features);
+}
+
+// Additionally lets the compiler use the BMI1 and BMI2 and-not and flagless shift instructions for the masks and fills.
+__attribute__((target("popcnt,bmi,bmi2"))) void Board::CountPawnFeaturesBmi2(bitboard64 whitePawns, bitboard64 blackPawns,
+																			PawnFeatures &features) {
+	CountPawnFeaturesSetwise(whitePawns, blackPawns, features);
+}
+#endif
+
 void Board::addPiece(Piece::Color color, Piece::Type type, position pos) {
-	Piece *piece = new Piece(color, type, pos);
 	// Insert into various structures.
-	pieceList[color].insert(piece);
-	internalBoard[pos] = piece;
-	if (type == Piece::PAWN) pawnStructure[color][pos] = true;
-	else if (type == Piece::KING) king[color] = piece;
+	internalBoard[pos] = Piece(color, type, pos);
+	hash ^= Zobrist::PieceSquare[color][type][pos];
+	attacksKnown = 0;
+	updateMaterial(color, type, 1);
+	updatePositionBonus(color, type, pos, 1);
+	pieces[color][type] |= Bitboard::Square(pos);
+	occupied[color] |= Bitboard::Square(pos);
+	if (type == Piece::KING) king[color] = pos;
 }
 
-void Board::move(Piece *piece, position to) {
-	// If the object is coming out of capture.
-	if (piece->pos < 0) {
-		captured.erase(piece);
-		pieceList[piece->color].insert(piece);
-	} else {
-		pawnStructure[piece->color][piece->pos] = false;
-		internalBoard[piece->pos] = 0;
-	}
-	piece->pos = to;
-	// If the object is being captured.
-	if (to < 0) {
-		pieceList[piece->color].erase(piece);
-		captured.insert(piece);
-	} else {
-		internalBoard[to] = piece;
-		if (piece->type == Piece::PAWN) pawnStructure[piece->color][piece->pos] = true;
-	}
+Piece Board::removePiece(position pos) {
+	Piece piece = internalBoard[pos];
+	internalBoard[pos] = Piece();
+	hash ^= Zobrist::PieceSquare[piece.color][piece.type][pos];
+	attacksKnown = 0;
+	updateMaterial(piece.color, piece.type, -1);
+	updatePositionBonus(piece.color, piece.type, pos, -1);
+	pieces[piece.color][piece.type] &= ~Bitboard::Square(pos);
+	occupied[piece.color] &= ~Bitboard::Square(pos);
+	return piece;
 }
 
-Piece* Board::getPiece(position pos) const {
-	return internalBoard[pos];
+const Piece* Board::getPiece(position pos) const {
+	return internalBoard[pos] ? &internalBoard[pos] : 0;
 }
 
-Piece* Board::getKing(Piece::Color color) const {
-	return king[color];
+const Piece* Board::getKing(Piece::Color color) const {
+	return king[color] >= 0 ? &internalBoard[king[color]] : 0;
 }
 
-PieceList::const_iterator Board::firstPieceItr(Piece::Color color) const {
-	return pieceList[color].begin();
+bitboard64 Board::getPieces(Piece::Color color, Piece::Type type) const {
+	return pieces[color][type];
 }
 
-PieceList::const_iterator Board::endPieceItr(Piece::Color color) const {
-	return pieceList[color].end();
+bitboard64 Board::getOccupied(Piece::Color color) const {
+	return occupied[color];
 }
 
-void Board::executeMove(const Move &move) {
-	// Move object first, to avoid the subject overwriting it in the event of a capture.
-	if (move.object) {
-		this->move(move.object, move.object_to);
+bitboard64 Board::getOccupied() const {
+	return occupied[Piece::WHITE] | occupied[Piece::BLACK];
+}
+
+bitboard64 Board::getAttacks(Piece::Color color) const {
+	if (attacksKnown & (1 << color)) return attacks[color];
+	bitboard64 occupiedAll = getOccupied();
+	bitboard64 queens = pieces[color][Piece::QUEEN];
+	bitboard64 map = 0;
+	for (bitboard64 pawns = pieces[color][Piece::PAWN]; pawns; ) map |= Bitboard::PawnAttacks[color][Bitboard::PopFirst(pawns)];
+	for (bitboard64 knights = pieces[color][Piece::KNIGHT]; knights; ) map |= Bitboard::KnightAttacks[Bitboard::PopFirst(knights)];
+	for (bitboard64 diagonals = pieces[color][Piece::BISHOP] | queens; diagonals; ) {
+		map |= Bitboard::BishopAttacks(Bitboard::PopFirst(diagonals), occupiedAll);
 	}
-	this->move(move.subject, move.subject_to);
-	if (move.type >= Move::PROMOTION) {
-		// Promote accordingly.
-		pawnStructure[move.subject->color][move.subject_to] = false;
-		move.subject->type = (Piece::Type)(move.type - Move::PROMOTION);
+	for (bitboard64 straights = pieces[color][Piece::ROOK] | queens; straights; ) {
+		map |= Bitboard::RookAttacks(Bitboard::PopFirst(straights), occupiedAll);
 	}
+	if (king[color] >= 0) map |= Bitboard::KingAttacks[king[color]];
+	attacks[color] = map;
+	attacksKnown |= 1 << color;
+	return map;
+}
+
+hashkey Board::getHash() const {
+	return hash;
+}
+
+void Board::executeMove(const Move &move) {
+	// Remove the object first, as a captured object is on the subject's destination.
+	if (move.object) removePiece(move.object_from);
+	Piece subject = removePiece(move.subject_from);
+	// Promote accordingly.
+	if (move.type >= Move::PROMOTION) subject.type = (Piece::Type)(move.type - Move::PROMOTION);
+	addPiece(subject.color, subject.type, move.subject_to);
+	// A castling rook moves, and a captured piece leaves the board.
+	if (move.object && move.object_to >= 0) addPiece(move.object.color, move.object.type, move.object_to);
 }
 
 void Board::reverseMove(const Move &move) {
-	// Move subject first, to avoid the object overwriting it in the event of reversing a capture.
-	this->move(move.subject, move.subject_from);
-	if (move.type >= Move::PROMOTION) {
-		// Unpromote back to pawn.
-		pawnStructure[move.subject->color][move.subject_from] = true;
-		move.subject->type = Piece::PAWN;
-	}
-	if (move.object) {
-		this->move(move.object, move.object_from);
-	}
+	removePiece(move.subject_to);
+	if (move.object && move.object_to >= 0) removePiece(move.object_to);
+	// The subject is stored as it was before the move, so a promoted piece is put back as a pawn.
+	addPiece(move.subject.color, move.subject.type, move.subject_from);
+	if (move.object) addPiece(move.object.color, move.object.type, move.object_from);
+}
+
+void Board::updatePositionBonus(Piece::Color color, Piece::Type type, position pos, int sign) {
+	positionBonus[color][Piece::MIDDLEGAME] += Piece::GetPositionBonus(color, type, pos, Piece::MIDDLEGAME) * sign;
+	positionBonus[color][Piece::ENDGAME] += Piece::GetPositionBonus(color, type, pos, Piece::ENDGAME) * sign;
+}
+
+void Board::updateMaterial(Piece::Color color, Piece::Type type, int sign) {
+	material[color] += Piece::MaterialWorth[type] * sign;
+	phase += Piece::PhaseWeight[type] * sign;
 }
 
 void Board::print() const {
@@ -208,7 +285,7 @@ void Board::print() const {
 	for (int rank = NUM_RANKS - 1; rank >= 0; rank--) {
 		std::cout << rank + 1 << ' ';
 		for (int file = 0; file < NUM_FILES; file++) {
-			Piece *piece = getPiece(Position::ToInt(file, rank));
+			const Piece *piece = getPiece(Position::ToInt(file, rank));
 			std::cout << ' ';
 			if (!piece) std::cout << '-';
 			else std::cout << Piece::Ascii[piece->color][piece->type];
@@ -1,25 +1,36 @@
 #pragma once
 
+#include <algorithm>
 #include <cctype>
 #include <stack>
 #include <string>
 #include "bitboard.hpp"
 #include "move.hpp"
+#include "pawntable.hpp"
 #include "piece.hpp"
 #include "position.hpp"
+#include "zobrist.hpp"
 
 namespace ChessProject {
 
+// The board holds no pointers or heap memory, so it can be copied (even with memcpy) to give another thread its own position to search.
 class Board {
 public:
-	~Board();
+	Board();
 	// Initialises all structures to their respective null values and sets up board.
 	void init();
-	// Deletes all piece references. Clears board.
+	// Removes every piece. Clears board.
 	void cleanup();
+	// If true, the piece square evaluation is interpolated between the middlegame and endgame tables according to the game phase.
+	//Otherwise, it uses the middlegame tables, and drops the king's bonus once isEndGame() becomes true, as the evaluation did before
+	//tapering.
+	static bool TaperedEval;
 	// Returns the material evaluation of the board relative to the specified color.
 	// For each piece, adds the piece square table associated to its position on the board.
-	int materialEval(Piece::Color color);
+	// Material and piece square totals are maintained incrementally as pieces move, so this doesn't need to visit every piece.
+	int materialEval(Piece::Color color) const;
+	// Returns the game phase, from Piece::MaxPhase at the start of the game to 0 when only kings and pawns remain.
+	int getPhase() const;
 	// Returns true if there is insufficient material for a checkmate to occur. This includes:
 	// 1 - king vs king
 	// 2 - king & bishop vs king
@@ -34,36 +45,83 @@ public:
 	// 2 - Isolated pawns.
 	// 3 - Doubled pawns.
 	// 4 - Backward pawns.
-	int pawnEval(Piece::Color color);
-	// Creates a new piece. Places it on the board and piecelist, and modifies appropriate piece structures.
+	// Results are cached in the calling thread's pawn table.
+	int pawnEval(Piece::Color color) const;
+	// The pawn structure terms of the evaluation, each counted as white's pawns less black's, and the passed pawns of each color.
+	struct PawnFeatures {
+		int passed;
+		int isolated;
+		int doubled;
+		int backward;
+		bitboard64 passedPawns[NUM_COLORS];
+	};
+	// Counts the pawn structure terms. The pawn structure evaluation is their sum, weighted by the pawn structure weightings in Piece.
+	void countPawnFeatures(PawnFeatures &features) const;
+	// Each thread caches pawn structure evaluations in its own table.
+	static thread_local PawnTable PawnHash;
+	// Places a new piece on the board, and modifies appropriate piece structures.
 	// Does not check the position to see if overwriting a piece.
 	void addPiece(Piece::Color color, Piece::Type type, position pos);
-	// Performs a move with no checks.
-	void move(Piece *piece, position to);
-	Piece* getPiece(position pos) const;
-	Piece* getKing(Piece::Color color) const;
-	// Returns const iterator to the first element of the piece list for the specified color.
-	PieceList::const_iterator firstPieceItr(Piece::Color color) const;
-	// Returns end iterator of the piece list for the specified color.
-	PieceList::const_iterator endPieceItr(Piece::Color color) const;
-	// Executes a move - Moves the object piece first (if there is one), followed by the subject piece. Updates piece structures accordingly.
+	// Returns the piece on a square, or null if the square is empty. The pointer is only valid until the board next changes.
+	const Piece* getPiece(position pos) const;
+	const Piece* getKing(Piece::Color color) const;
+	// Returns a bitboard of the squares occupied by pieces of the given color and type.
+	bitboard64 getPieces(Piece::Color color, Piece::Type type) const;
+	// Returns a bitboard of the squares occupied by pieces of the given color.
+	bitboard64 getOccupied(Piece::Color color) const;
+	// Returns a bitboard of every occupied square.
+	bitboard64 getOccupied() const;
+	// Returns the squares attacked by the pieces of the given color. The attack map of each color is calculated the first time it is asked for
+	//after the board changes, and then reused, so threat tests, check detection and evaluation of the same position share one calculation.
+	bitboard64 getAttacks(Piece::Color color) const;
+	// Returns the Zobrist hash of the pieces on the board. Side to move, castling and en passant are hashed by GameInfo.
+	hashkey getHash() const;
+	// Executes a move - Removes the object piece first (if there is one), followed by the subject piece, then places them on their
+	//destinations. Updates piece structures accordingly.
 	void executeMove(const Move &move);
-	// Reverses a move that has already been made. First, moves the subject back, followed by the object. Unpromotes if necessary.
+	// Reverses a move that has already been made. The pieces stored in the move are put back where they came from, which also unpromotes.
 	void reverseMove(const Move &move);
 	void print() const;
 private:
-	// The board is represented by a 64 length array of Piece pointers. A null pointer means an empty square.
-	Piece *internalBoard[BOARDSIZE];
-	// The pieces are also held in this list, so that they can be iterated over without checking all 64 squares.
-	PieceList pieceList[NUM_COLORS];
-	// This is a list of all of the pieces that have been captured. It is useful to keep the pieces that have been captured in order to
-	//take back a capture.
-	PieceList captured;
-	// The pawn structure for each color is stored as a 64-bit word with 1s as pawns and 0s as not pawns. Storing pawn structure in this
-	//way helps speed up pawn evaluations.
-	bitboard pawnStructure[NUM_COLORS];
+	// The board is represented by a 64 length array of pieces. The null piece means an empty square. The pieces of each color and type can be
+	//iterated over with the bitboards below, without checking all 64 squares.
+	Piece internalBoard[BOARDSIZE];
+	// Every piece type and color also has a 64-bit bitboard of the squares it occupies. These are used by the move generator and by the
+	//pawn structure evaluation.
+	bitboard64 pieces[NUM_COLORS][NUM_PIECE_TYPES];
+	bitboard64 occupied[NUM_COLORS];
+	// The attack maps of each color, and a bit for each color that is set while its map is up to date. Adding or removing any piece clears
+	//the bits.
+	mutable bitboard64 attacks[NUM_COLORS];
+	mutable int attacksKnown;
 	// It is often useful to directly access the kings of the board in order to check for check, checkmate and such.
-	Piece *king[NUM_COLORS];
+	position king[NUM_COLORS];
+	// The Zobrist hash of every piece on the board, updated incrementally as pieces are added, moved and promoted.
+	hashkey hash;
+	// Running totals of material worth and piece square bonuses (for each game phase) for each color, and of the phase weights of
+	//every piece on the board. These are updated alongside the hash.
+	int material[NUM_COLORS];
+	int positionBonus[NUM_COLORS][NUM_GAME_PHASES];
+	int phase;
+	// Evaluates the pawn structure relative to white, filling in the score and passed pawns of the entry.
+	void evalPawnStructure(PawnTable::Entry &entry) const;
+	// The pawn structure terms are counted with whole-board shifts and population counts, without looping over pawns or files. The same
+	//code is compiled once for each instruction set below, and CountPawnFeatures points at the best one the CPU supports.
+	typedef void (*PawnFeatureCounter)(bitboard64 whitePawns, bitboard64 blackPawns, PawnFeatures &features);
+	static const PawnFeatureCounter CountPawnFeatures;
+	static PawnFeatureCounter SelectPawnFeatureCounter();
+	static inline void CountPawnFeaturesSetwise(bitboard64 whitePawns, bitboard64 blackPawns, PawnFeatures &features);
+	static void CountPawnFeaturesGeneric(bitboard64 whitePawns, bitboard64 blackPawns, PawnFeatures &features);
+#if defined(__x86_64__) || defined(__i386__)
+	static void CountPawnFeaturesPopcnt(bitboard64 whitePawns, bitboard64 blackPawns, PawnFeatures &features);
+	static void CountPawnFeaturesBmi2(bitboard64 whitePawns, bitboard64 blackPawns, PawnFeatures &features);
+#endif
+	// Removes the piece on a square, and returns it.
+	Piece removePiece(position pos);
+	// Adds (sign = 1) or removes (sign = -1) a piece's piece square bonuses to or from the running totals.
+	void updatePositionBonus(Piece::Color color, Piece::Type type, position pos, int sign);
+	// Adds or removes a piece's material worth and phase weight to or from the running totals.
+	void updateMaterial(Piece::Color color, Piece::Type type, int sign);
 };
 
 }
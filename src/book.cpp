@@ -0,0 +1,171 @@
+#include "book.hpp"
+
+namespace ChessProject {
+
+const Piece::Type Book::PromotionTypes[NumPromotionCodes] = { Piece::NONE, Piece::KNIGHT, Piece::BISHOP, Piece::ROOK, Piece::QUEEN };
+const char Book::Magic[8] = { 'T', 'Y', 'C', 'P', 'B', 'O', 'O', 'K' };
+const uint32_t Book::FormatVersion;
+thread_local uint64_t Book::Seed = 0;
+
+Book::Book() :
+	numEntries(0) { }
+
+Book::~Book() {
+	close();
+}
+
+Book::OpenResult Book::open(const std::string &path) {
+	close();
+	if (!file.open(path)) return CANT_READ;
+	const unsigned char *header = file.data();
+	if (file.size() < HeaderSize || !std::equal(Magic, Magic + sizeof(Magic), (const char*)header)) {
+		close();
+		return WRONG_FORMAT;
+	}
+	uint32_t version = ((uint32_t)header[8] << 24) | ((uint32_t)header[9] << 16) | ((uint32_t)header[10] << 8) | header[11];
+	uint32_t count = ((uint32_t)header[12] << 24) | ((uint32_t)header[13] << 16) | ((uint32_t)header[14] << 8) | header[15];
+	if (version != FormatVersion || file.size() != HeaderSize + count * EntrySize) {
+		close();
+		return WRONG_FORMAT;
+	}
+	numEntries = count;
+	return OPENED;
+}
+
+void Book::close() {
+	file.close();
+	numEntries = 0;
+}
+
+bool Book::isOpen() const {
+	return file.isOpen();
+}
+
+std::size_t Book::size() const {
+	return numEntries;
+}
+
+bool Book::find(const Board *board, const GameInfo *gameInfo, std::vector<Entry> &entries) const {
+	entries.clear();
+	hashkey key = Key(board, gameInfo);
+	// Binary search for the first entry with the key.
+	std::size_t first = 0, last = numEntries;
+	while (first < last) {
+		std::size_t middle = first + (last - first) / 2;
+		if (entryAt(middle).key < key) first = middle + 1;
+		else last = middle;
+	}
+	for (std::size_t i = first; i < numEntries; i++) {
+		Entry entry = entryAt(i);
+		if (entry.key != key) break;
+		entries.push_back(entry);
+	}
+	return !entries.empty();
+}
+
+bool Book::probe(Board *board, GameInfo *gameInfo, Move &move) const {
+	std::vector<Entry> entries;
+	if (!find(board, gameInfo, entries)) return false;
+	// Only the legal moves take part in the draw.
+	std::vector<Move> moves;
+	std::vector<unsigned long> weights;
+	unsigned long totalWeight = 0;
+	for (std::vector<Entry>::iterator entryItr = entries.begin(); entryItr != entries.end(); entryItr++) {
+		Move bookMove;
+		if (entryItr->weight == 0 || !DecodeMove(entryItr->move, board, gameInfo, bookMove)) continue;
+		moves.push_back(bookMove);
+		weights.push_back(entryItr->weight);
+		totalWeight += entryItr->weight;
+	}
+	if (moves.empty()) return false;
+	unsigned long pick = Random64() % totalWeight;
+	for (std::size_t i = 0; i < moves.size(); i++) {
+		if (pick < weights[i]) {
+			move = moves[i];
+			return true;
+		}
+		pick -= weights[i];
+	}
+	return false;
+}
+
+hashkey Book::Key(const Board *board, const GameInfo *gameInfo) {
+	return board->getHash() ^ gameInfo->hash;
+}
+
+uint16_t Book::EncodeMove(const Move &move) {
+	position to = move.subject_to;
+	// Castling is the only move with a rook as the object that isn't a capture.
+	if (move.subject.type == Piece::KING && move.object && move.object.color == move.subject.color) to = move.object_from;
+	int promotion = 0;
+	if (move.type >= Move::PROMOTION) {
+		while (PromotionTypes[promotion] != move.type - Move::PROMOTION) promotion++;
+	}
+	return (uint16_t)(to | (move.subject_from << 6) | (promotion << 12));
+}
+
+bool Book::DecodeMove(uint16_t encoded, Board *board, GameInfo *gameInfo, Move &move) {
+	// The moves of the piece on the source square are generated, and encoded to compare against.
+	position from = (encoded >> 6) & 63;
+	if (((encoded >> 12) & 7) >= NumPromotionCodes) return false;
+	const Piece *piece = board->getPiece(from);
+	if (!piece || piece->color != gameInfo->turn) return false;
+	MoveList moveList;
+	moveList.generateLegal(gameInfo->turn, board, gameInfo, Bitboard::Square(from), true, true);
+	for (MoveList::iterator moveItr = moveList.begin(); moveItr != moveList.end(); moveItr++) {
+		if (EncodeMove(*moveItr) == encoded) {
+			move = *moveItr;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Book::Write(const std::string &path, std::vector<Entry> &entries) {
+	std::stable_sort(entries.begin(), entries.end(), CompareKeys);
+	std::vector<unsigned char> bytes(HeaderSize + entries.size() * EntrySize);
+	std::copy(Magic, Magic + sizeof(Magic), bytes.begin());
+	for (int byte = 0; byte < 4; byte++) {
+		bytes[8 + byte] = (unsigned char)(FormatVersion >> (24 - byte * 8));
+		bytes[12 + byte] = (unsigned char)((uint32_t)entries.size() >> (24 - byte * 8));
+	}
+	for (std::size_t i = 0; i < entries.size(); i++) {
+		unsigned char *out = &bytes[HeaderSize + i * EntrySize];
+		for (int byte = 0; byte < 8; byte++) out[byte] = (unsigned char)(entries[i].key >> (56 - byte * 8));
+		out[8] = (unsigned char)(entries[i].move >> 8);
+		out[9] = (unsigned char)entries[i].move;
+		out[10] = (unsigned char)(entries[i].weight >> 8);
+		out[11] = (unsigned char)entries[i].weight;
+		for (int byte = 0; byte < 4; byte++) out[12 + byte] = (unsigned char)(entries[i].learn >> (24 - byte * 8));
+	}
+	std::ofstream stream(path.c_str(), std::ios::binary | std::ios::trunc);
+	stream.write((const char*)&bytes[0], bytes.size());
+	stream.close();
+	return !stream.fail();
+}
+
+uint64_t Book::Random64() {
+	if (Seed == 0) Seed = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count() | 1;
+	// xorshift64* pseudo-random number generator.
+	Seed ^= Seed >> 12;
+	Seed ^= Seed << 25;
+	Seed ^= Seed >> 27;
+	return Seed * 0x2545F4914F6CDD1DULL;
+}
+
+Book::Entry Book::entryAt(std::size_t index) const {
+	const unsigned char *in = file.data() + HeaderSize + index * EntrySize;
+	Entry entry;
+	entry.key = 0;
+	for (int byte = 0; byte < 8; byte++) entry.key = (entry.key << 8) | in[byte];
+	entry.move = (uint16_t)((in[8] << 8) | in[9]);
+	entry.weight = (uint16_t)((in[10] << 8) | in[11]);
+	entry.learn = ((uint32_t)in[12] << 24) | ((uint32_t)in[13] << 16) | ((uint32_t)in[14] << 8) | in[15];
+	return entry;
+}
+
+bool Book::CompareKeys(const Entry &entry1, const Entry &entry2) {
+	return entry1.key < entry2.key;
+}
+
+}
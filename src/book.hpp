@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "gameinfo.hpp"
+#include "mappedfile.hpp"
+#include "move.hpp"
+#include "movelist.hpp"
+#include "zobrist.hpp"
+
+namespace ChessProject {
+
+// An opening book holds moves to play in known positions, so that the opening takes a lookup rather than a search.
+// After a 16 byte header, the file uses the Polyglot entry layout: a sorted array of 16 byte entries, each holding a position key, a move,
+//a weight and a learn value, all big-endian. The file is memory mapped and binary searched where it lies, so opening a book costs nothing
+//however large it is. The keys are the engine's own Zobrist hashes rather than Polyglot's, so books are built with the book tool rather
+//than taken from elsewhere. The header holds Magic, FormatVersion and the number of entries, so that a Polyglot book (or any other file)
+//is rejected when it is opened, instead of silently never matching a position.
+class Book {
+public:
+	struct Entry {
+		hashkey key;
+		// Polyglot move encoding. Bits 0-5: destination. 6-11: source. 12-14: promotion (0 none, 1 knight, 2 bishop, 3 rook, 4 queen).
+		//Castling is stored as the king moving to the rook's square.
+		uint16_t move;
+		// Moves are picked in proportion to their weight.
+		uint16_t weight;
+		uint32_t learn;
+	};
+	static const std::size_t EntrySize = 16;
+	static const std::size_t HeaderSize = 16;
+	// The first 8 bytes of every book file, followed by the big-endian format version and number of entries. The version changes whenever
+	//the keys or the move encoding do.
+	static const char Magic[8];
+	static const uint32_t FormatVersion = 1;
+	enum OpenResult {
+		OPENED,
+		// The file doesn't exist or can't be mapped.
+		CANT_READ,
+		// The file isn't a book written by Write in this format version, or has been truncated.
+		WRONG_FORMAT
+	};
+	Book();
+	~Book();
+	// Maps a book file into memory, closing any book already open. Unless it returns OPENED, no book is left open.
+	OpenResult open(const std::string &path);
+	void close();
+	bool isOpen() const;
+	// Number of entries in the book.
+	std::size_t size() const;
+	// Stores every entry for the position in entries. Returns false if the position isn't in the book.
+	bool find(const Board *board, const GameInfo *gameInfo, std::vector<Entry> &entries) const;
+	// Picks one of the book moves of the position at random, in proportion to their weights, and stores it in move. Returns false if the
+	//position isn't in the book or none of its moves are legal (which would mean two positions share a key).
+	bool probe(Board *board, GameInfo *gameInfo, Move &move) const;
+	// Returns the key of a position.
+	static hashkey Key(const Board *board, const GameInfo *gameInfo);
+	static uint16_t EncodeMove(const Move &move);
+	// Finds the legal move with the given encoding. Returns false if there is no such move.
+	static bool DecodeMove(uint16_t encoded, Board *board, GameInfo *gameInfo, Move &move);
+	// Sorts entries by key and writes them to a book file. Returns false if the file can't be written.
+	static bool Write(const std::string &path, std::vector<Entry> &entries);
+private:
+	// The piece promoted to by each Polyglot promotion code.
+	static const int NumPromotionCodes = 5;
+	static const Piece::Type PromotionTypes[NumPromotionCodes];
+	MappedFile file;
+	std::size_t numEntries;
+	// Random number generator state for picking moves. Every thread has its own, seeded from the clock when first used.
+	static thread_local uint64_t Seed;
+	static uint64_t Random64();
+	// Returns the entry at an index of the mapped file.
+	Entry entryAt(std::size_t index) const;
+	static bool CompareKeys(const Entry &entry1, const Entry &entry2);
+};
+
+}
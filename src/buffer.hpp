@@ -1,38 +1,76 @@
 #pragma once
 
-#include <set>
-#include <boost/assign.hpp>
 #include "piece.hpp"
 #include "position.hpp"
 
 #define BUFFERSIZE 120
+#define MAX_OFFSETS 8
 
 namespace ChessProject {
 
-typedef std::set<int> intlist;
-
 // The buffer class is used for dealing with the buffer board - a 120-length array that represents an 8 x 8 chess board surrounded by a buffer zone
 //that allows for detection of moves that will take a piece off the board. Whilst moves are being generated, each piece will check their position
 //plus a certain offset to see if it is on the board using something like "int newPosition = Buffer::Board[Buffer::Coords[currentPosition] + directionOffset]".
 // A negative position indicates one that is off the board.
 struct Buffer {
 	// These direction constants represent the position offset for a move along one tile.
-	static const int N;
-	static const int S;
-	static const int W;
-	static const int E;
-	static const int NE;
-	static const int SE;
-	static const int SW;
-	static const int NW;
+	static constexpr int N = 10;
+	static constexpr int S = -10;
+	static constexpr int W = -1;
+	static constexpr int E = 1;
+	static constexpr int NE = N + E;
+	static constexpr int SE = S + E;
+	static constexpr int SW = S + W;
+	static constexpr int NW = N + W;
 	// The 120-length buffer board.
-	static const position Board[BUFFERSIZE];
+	static constexpr position Board[BUFFERSIZE] = {
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1,  0,  1,  2,  3,  4,  5,  6,  7, -1,
+		-1,  8,  9, 10, 11, 12, 13, 14, 15, -1,
+		-1, 16, 17, 18, 19, 20, 21, 22, 23, -1,
+		-1, 24, 25, 26, 27, 28, 29, 30, 31, -1,
+		-1, 32, 33, 34, 35, 36, 37, 38, 39, -1,
+		-1, 40, 41, 42, 43, 44, 45, 46, 47, -1,
+		-1, 48, 49, 50, 51, 52, 53, 54, 55, -1,
+		-1, 56, 57, 58, 59, 60, 61, 62, 63, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+	};
 	// This array is used to translate a position on the 8 x 8 chess board onto the buffer board.
-	static const int Coords[BOARDSIZE];
-	// Array of direction offsets for each individual piece type.
-	static const intlist Offset[NUM_PIECE_TYPES];
+	static constexpr int Coords[BOARDSIZE] = {
+		21, 22, 23, 24, 25, 26, 27, 28,
+		31, 32, 33, 34, 35, 36, 37, 38,
+		41, 42, 43, 44, 45, 46, 47, 48,
+		51, 52, 53, 54, 55, 56, 57, 58,
+		61, 62, 63, 64, 65, 66, 67, 68,
+		71, 72, 73, 74, 75, 76, 77, 78,
+		81, 82, 83, 84, 85, 86, 87, 88,
+		91, 92, 93, 94, 95, 96, 97, 98
+	};
+	// The direction offsets for each individual piece type. Only the first NumOffsets of each row are used. The tables are constant
+	//expressions, so the attack tables in Bitboard can be generated from them at compile time.
+	static constexpr int Offset[NUM_PIECE_TYPES][MAX_OFFSETS] = {
+		{ NE, SE, SW, NW }, // Bishop
+		{ N, NE, E, SE, S, SW, W, NW }, // King
+		{ N + NE, E + NE, E + SE, S + SE, S + SW, W + SW, W + NW, N + NW }, // Knight
+		{ }, // Pawn
+		{ N, NE, E, SE, S, SW, W, NW }, // Queen
+		{ N, E, S, W } // Rook
+	};
+	static constexpr int NumOffsets[NUM_PIECE_TYPES] = {
+		4, // Bishop
+		8, // King
+		8, // Knight
+		0, // Pawn
+		8, // Queen
+		4 // Rook
+	};
 	// Array of offsets for pawn advance.
-	static const int PawnOffset[NUM_COLORS];
+	static constexpr int PawnOffset[NUM_COLORS] = {
+		N, // White
+		S // Black
+	};
 };
 
 }
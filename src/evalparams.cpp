@@ -0,0 +1,140 @@
+#include "evalparams.hpp"
+
+namespace ChessProject {
+
+int EvalParams::Weights[NUM_PARAMS] = {
+	// Material worth.
+	300, // Bishop
+	10000, // King - arbitrarily large
+	300, // Knight
+	100, // Pawn
+	900, // Queen
+	500, // Rook
+	// The piece square tables. The values in the table for each piece are added to its material worth in the evaluation function.
+	// In order to encourage piece development near the beginning of the game, almost every piece table penalizes pieces in their starting positions.
+	// Bishop - Centre squares are better due to increased mobility.
+	 -5,  -5, -10,  -5,  -5, -10,  -5,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	 -5,   0,   5,  10,  10,   5,   0,  -5,
+	 -5,   0,   5,  10,  10,   5,   0,  -5,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,
+	// King - Castling is encouraged. Staying at the home front is greatly encouraged.
+	  5,   5,  10,   0,  -5,   0,  10,   5,
+	-10, -10, -10, -10, -10, -10, -10, -10,
+	-20, -20, -20, -20, -20, -20, -20, -20,
+	-20, -20, -20, -20, -20, -20, -20, -20,
+	-20, -20, -20, -20, -20, -20, -20, -20,
+	-20, -20, -20, -20, -20, -20, -20, -20,
+	-20, -20, -20, -20, -20, -20, -20, -20,
+	-20, -20, -20, -20, -20, -20, -20, -20,
+	// Knight - Knights are encouraged to leave their starting positions very early. Otherwise, control of the center and mobility are most important.
+	 -5, -10,  -5,  -5,  -5,  -5, -10,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	 -5,   0,   5,  10,  10,   5,   0,  -5,
+	 -5,   0,   5,  10,  10,   5,   0,  -5,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,
+	// Pawn - Pawns are encouraged to promote, and allow the bishop/queen to leave their starting positions.
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,  -5,  -5,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 40,  40,  40,  40,  40,  40,  40,  40,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	// Queen
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	// Rook - Rooks are encouraged to occupy the seventh rank. Otherwise, any position is good.
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 20,  20,  20,  20,  20,  20,  20,  20,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	// The endgame king table. The middlegame king table is a cautious one. In the endgame, the king is safe enough to become an active piece, and is encouraged
+	//towards the centre instead. All other pieces use the same table in both phases.
+	-30, -20, -10, -10, -10, -10, -20, -30,
+	-20, -10,   0,   0,   0,   0, -10, -20,
+	-10,   0,  10,  15,  15,  10,   0, -10,
+	-10,   0,  15,  20,  20,  15,   0, -10,
+	-10,   0,  15,  20,  20,  15,   0, -10,
+	-10,   0,  10,  15,  15,  10,   0, -10,
+	-20, -10,   0,   0,   0,   0, -10, -20,
+	-30, -20, -10, -10, -10, -10, -20, -30,
+	// Pawn structure.
+	-10, // Doubled pawn penalty
+	-20, // Isolated pawn penalty
+	20, // Passed pawn bonus
+	100, // Endgame passed pawn bonus
+	-10, // Backward pawn penalty
+	// Pieces.
+	20, // Both bishops bonus
+	10, // Rook on open file
+	// The bonus given to a team for attacking a center square.
+	20 // Center control bonus
+};
+
+std::string EvalParams::Name(int param) {
+	if (param < BONUS_TABLE) return "MaterialWorth[" + Piece::TypeString[param - MATERIAL_WORTH] + "]";
+	if (param < ENDGAME_KING_TABLE) {
+		int index = param - BONUS_TABLE;
+		return "BonusTable[" + Piece::TypeString[index / BOARDSIZE] + "][" + Position::ToAlgebraic(index % BOARDSIZE) + "]";
+	}
+	if (param < DOUBLED_PAWN_PENALTY) return "EndGameKingTable[" + Position::ToAlgebraic(param - ENDGAME_KING_TABLE) + "]";
+	static const std::string Names[NUM_PARAMS - DOUBLED_PAWN_PENALTY] = {
+		"DoubledPawnPenalty",
+		"IsolatedPawnPenalty",
+		"PassedPawnBonus",
+		"EndGamePassedPawnBonus",
+		"BackwardPawnPenalty",
+		"BothBishopsBonus",
+		"RookOnOpenFile",
+		"CenterControlBonus"
+	};
+	return Names[param - DOUBLED_PAWN_PENALTY];
+}
+
+bool EvalParams::Load(const std::string &path) {
+	std::ifstream file(path.c_str());
+	if (!file) return false;
+	std::map<std::string, int> params;
+	for (int param = 0; param < NUM_PARAMS; param++) params[Name(param)] = param;
+	int weights[NUM_PARAMS];
+	std::copy(Weights, Weights + NUM_PARAMS, weights);
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		std::string name;
+		int value;
+		if (!(fields >> name)) continue;
+		std::map<std::string, int>::iterator paramItr = params.find(name);
+		if (paramItr == params.end() || !(fields >> value)) return false;
+		weights[paramItr->second] = value;
+	}
+	std::copy(weights, weights + NUM_PARAMS, Weights);
+	return true;
+}
+
+bool EvalParams::Save(const std::string &path) {
+	std::ofstream file(path.c_str());
+	for (int param = 0; param < NUM_PARAMS; param++) file << Name(param) << ' ' << Weights[param] << '\n';
+	file.close();
+	return !file.fail();
+}
+
+}
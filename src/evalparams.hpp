@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include "piece.hpp"
+#include "position.hpp"
+
+namespace ChessProject {
+
+// The weights of the evaluation function, kept together in one flat vector of parameters rather than as separate constants, so that the
+//tune tool can adjust every one of them alike. The names the evaluation uses (Piece::MaterialWorth, Piece::DoubledPawnPenalty,
+//Minimax::CenterControlBonus and so on) refer into the vector.
+// The weights can be replaced at run time with a file written by the tune tool. Boards keep running totals of material and piece square
+//bonuses, so any board set up before the weights change has to be set up again.
+struct EvalParams {
+	// The index of each weight, or of the first weight of each table, in the vector.
+	enum Param {
+		MATERIAL_WORTH = 0,
+		BONUS_TABLE = MATERIAL_WORTH + NUM_PIECE_TYPES,
+		ENDGAME_KING_TABLE = BONUS_TABLE + NUM_PIECE_TYPES * BOARDSIZE,
+		DOUBLED_PAWN_PENALTY = ENDGAME_KING_TABLE + BOARDSIZE,
+		ISOLATED_PAWN_PENALTY,
+		PASSED_PAWN_BONUS,
+		ENDGAME_PASSED_PAWN_BONUS,
+		BACKWARD_PAWN_PENALTY,
+		BOTH_BISHOPS_BONUS,
+		ROOK_ON_OPEN_FILE,
+		CENTER_CONTROL_BONUS,
+		NUM_PARAMS
+	};
+	static int Weights[NUM_PARAMS];
+	// Returns the name of a weight, such as MaterialWorth[PAWN] or BonusTable[KNIGHT][e4].
+	static std::string Name(int param);
+	// Reads weights from a file of "name value" lines. Weights the file doesn't name are left as they are. Returns false, changing
+	//nothing, if the file can't be read or holds a line that isn't a known weight.
+	static bool Load(const std::string &path);
+	// Writes every weight to a file that Load can read. Returns false if the file can't be written.
+	static bool Save(const std::string &path);
+};
+
+}
@@ -0,0 +1,109 @@
+#include "fen.hpp"
+
+namespace ChessProject {
+
+const std::string Fen::InitialPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+bool Fen::Load(const std::string &fen, Board *board, GameInfo *info) {
+	std::istringstream stream(fen);
+	std::string placement, turn, castling = "-", enPassant = "-";
+	if (!(stream >> placement >> turn)) return false;
+	stream >> castling >> enPassant;
+	// The move counters are optional.
+	int halfmove = 0, fullmove = 1;
+	if (!(stream >> halfmove)) halfmove = 0;
+	else if (!(stream >> fullmove)) fullmove = 1;
+	// Piece placement, starting from the eighth rank.
+	board->cleanup();
+	int file = 0, rank = NUM_RANKS - 1;
+	for (std::string::size_type i = 0; i < placement.size(); i++) {
+		char c = placement[i];
+		if (c == '/') {
+			if (file != NUM_FILES || --rank < 0) return false;
+			file = 0;
+		} else if (c >= '1' && c <= '8') {
+			file += c - '0';
+			if (file > NUM_FILES) return false;
+		} else {
+			Piece::Color color = std::isupper(c) ? Piece::WHITE : Piece::BLACK;
+			int type = 0;
+			while (type < NUM_PIECE_TYPES && Piece::Ascii[color][type] != c) type++;
+			if (type == NUM_PIECE_TYPES || file >= NUM_FILES) return false;
+			board->addPiece(color, (Piece::Type)type, Position::ToInt(file, rank));
+			file++;
+		}
+	}
+	if (rank != 0 || file != NUM_FILES) return false;
+	for (int color = 0; color < NUM_COLORS; color++) {
+		if (__builtin_popcountll(board->getPieces((Piece::Color)color, Piece::KING)) != 1) return false;
+	}
+	info->init();
+	if (turn == "w") info->turn = Piece::WHITE;
+	else if (turn == "b") info->turn = Piece::BLACK;
+	else return false;
+	// Castling is only made available if the king and rook are still on their initial squares.
+	info->castlingUnavailability = GameInfo::CastlingFlag[Piece::WHITE][GameInfo::KINGSIDE] | GameInfo::CastlingFlag[Piece::WHITE][GameInfo::QUEENSIDE] |
+								   GameInfo::CastlingFlag[Piece::BLACK][GameInfo::KINGSIDE] | GameInfo::CastlingFlag[Piece::BLACK][GameInfo::QUEENSIDE];
+	for (std::string::size_type i = 0; i < castling.size() && castling != "-"; i++) {
+		Piece::Color color = std::isupper(castling[i]) ? Piece::WHITE : Piece::BLACK;
+		GameInfo::Side side;
+		switch (std::tolower(castling[i])) {
+			case 'k': side = GameInfo::KINGSIDE; break;
+			case 'q': side = GameInfo::QUEENSIDE; break;
+			default: return false;
+		}
+		position kingPos = __builtin_ctzll(Piece::InitialSetup[color][Piece::KING]);
+		position rookPos = (side == GameInfo::KINGSIDE ? kingPos + 3 : kingPos - 4);
+		const Piece *king = board->getPiece(kingPos);
+		const Piece *rook = board->getPiece(rookPos);
+		if (king && king->type == Piece::KING && king->color == color && rook && rook->type == Piece::ROOK && rook->color == color) {
+			info->castlingUnavailability &= ~GameInfo::CastlingFlag[color][side];
+		}
+	}
+	// The en passant square is the one behind the pawn that has just double advanced.
+	if (enPassant != "-") {
+		position square = Position::FromAlgebraic(enPassant);
+		if (square < 0) return false;
+		const Piece *target = board->getPiece(square + (info->turn == Piece::WHITE ? -NUM_FILES : NUM_FILES));
+		if (target && target->type == Piece::PAWN && target->color != info->turn) info->enPassantTarget = target->pos;
+	}
+	info->fiftyMoveRuleCounter = halfmove;
+	info->numTurns = std::max(fullmove - 1, 0);
+	info->updateHash();
+	return true;
+}
+
+std::string Fen::Save(const Board *board, const GameInfo *info) {
+	std::ostringstream stream;
+	for (int rank = NUM_RANKS - 1; rank >= 0; rank--) {
+		int empty = 0;
+		for (int file = 0; file < NUM_FILES; file++) {
+			const Piece *piece = board->getPiece(Position::ToInt(file, rank));
+			if (!piece) {
+				empty++;
+				continue;
+			}
+			if (empty > 0) stream << empty;
+			empty = 0;
+			stream << Piece::Ascii[piece->color][piece->type];
+		}
+		if (empty > 0) stream << empty;
+		if (rank > 0) stream << '/';
+	}
+	stream << (info->turn == Piece::WHITE ? " w " : " b ");
+	std::string castling;
+	if (!(info->castlingUnavailability & GameInfo::CastlingFlag[Piece::WHITE][GameInfo::KINGSIDE])) castling += 'K';
+	if (!(info->castlingUnavailability & GameInfo::CastlingFlag[Piece::WHITE][GameInfo::QUEENSIDE])) castling += 'Q';
+	if (!(info->castlingUnavailability & GameInfo::CastlingFlag[Piece::BLACK][GameInfo::KINGSIDE])) castling += 'k';
+	if (!(info->castlingUnavailability & GameInfo::CastlingFlag[Piece::BLACK][GameInfo::QUEENSIDE])) castling += 'q';
+	stream << (castling.empty() ? "-" : castling) << ' ';
+	if (info->enPassantTarget >= 0) {
+		stream << Position::ToAlgebraic(info->enPassantTarget + (info->turn == Piece::WHITE ? NUM_FILES : -NUM_FILES));
+	} else {
+		stream << '-';
+	}
+	stream << ' ' << info->fiftyMoveRuleCounter << ' ' << info->numTurns + 1;
+	return stream.str();
+}
+
+}
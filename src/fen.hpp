@@ -0,0 +1,24 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <string>
+#include "board.hpp"
+#include "gameinfo.hpp"
+
+namespace ChessProject {
+
+// Forsyth-Edwards Notation (FEN) describes a position in one line of text, for example the initial position:
+//"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+// The fields are piece placement, side to move, castling availability, en passant target square, halfmove clock and fullmove number.
+struct Fen {
+	static const std::string InitialPosition;
+	// Sets up the board and game info from a FEN string. The halfmove clock and fullmove number may be omitted (as they are in EPD).
+	//Returns false if the string is not a valid position, in which case the board and game info are left in an undefined state.
+	static bool Load(const std::string &fen, Board *board, GameInfo *info);
+	// Returns the FEN string of a position.
+	static std::string Save(const Board *board, const GameInfo *info);
+};
+
+}
@@ -6,9 +6,16 @@ GameInfo::Irreversible::Irreversible(GameInfo *info) :
 	castlingUnavailability(info->castlingUnavailability),
 	fiftyMoveRuleCounter(info->fiftyMoveRuleCounter),
 	enPassantTarget(info->enPassantTarget),
-	inCheck(info->inCheck) { }
+	inCheck(info->inCheck),
+	hash(info->hash) { }
 
-const int GameInfo::CastlingMask[BOARDSIZE] = {
+constexpr int GameInfo::CastlingFlag[NUM_COLORS][NUM_SIDES] = {
+	{ 1 << 0, 1 << 1 }, // WHITE
+	{ 1 << 2, 1 << 3 } // BLACK
+};
+
+// The mask is built from the flags above at compile time, so it is never read before it is initialised.
+constexpr int GameInfo::CastlingMask[BOARDSIZE] = {
 	CastlingFlag[Piece::WHITE][QUEENSIDE], 0, 0, 0, CastlingFlag[Piece::WHITE][QUEENSIDE] | CastlingFlag[Piece::WHITE][KINGSIDE], 0, 0, CastlingFlag[Piece::WHITE][KINGSIDE],
 	0									 , 0, 0, 0, 0																			, 0, 0, 0									,
 	0									 , 0, 0, 0, 0																			, 0, 0, 0									,
@@ -19,29 +26,28 @@ const int GameInfo::CastlingMask[BOARDSIZE] = {
 	CastlingFlag[Piece::BLACK][QUEENSIDE], 0, 0, 0, CastlingFlag[Piece::BLACK][QUEENSIDE] | CastlingFlag[Piece::BLACK][KINGSIDE], 0, 0, CastlingFlag[Piece::BLACK][KINGSIDE]
 };
 
-const int GameInfo::CastlingFlag[NUM_COLORS][NUM_SIDES] = {
-	{ 1 << 0, 1 << 1 }, // WHITE
-	{ 1 << 2, 1 << 3 } // BLACK
-};
-
 void GameInfo::init() {
 	castlingUnavailability = 0;
 	numTurns = 0;
 	fiftyMoveRuleCounter = 0;
 	turn = Piece::WHITE;
-	enPassantTarget = 0;
+	enPassantTarget = -1;
 	inCheck = false;
+	updateHash();
 }
 
 bool GameInfo::canCastle(Piece::Color color, Side side, Board *board) {
 	// Castling cannot occur whilst the king is in check.
 	if (inCheck || (castlingUnavailability & CastlingFlag[color][side])) return false;
 	position kingPos = (color == Piece::WHITE ? 4 : 60);
-	// Check all positions between the king and rook. If they are empty, castling can occur.
+	// Check all positions between the king and rook. If they are empty, castling can occur. The king also can't pass through a square that is
+	//under threat. (Its destination is checked by the move generator.)
 	if (side == KINGSIDE) {
-		return !board->getPiece(kingPos + 1) && !board->getPiece(kingPos + 2);
+		return !board->getPiece(kingPos + 1) && !board->getPiece(kingPos + 2) &&
+			   !MoveList::UnderThreat(kingPos + 1, (Piece::Color)!color, board);
 	} else {
-		return !board->getPiece(kingPos - 1) && !board->getPiece(kingPos - 2) && !board->getPiece(kingPos - 3);
+		return !board->getPiece(kingPos - 1) && !board->getPiece(kingPos - 2) && !board->getPiece(kingPos - 3) &&
+			   !MoveList::UnderThreat(kingPos - 1, (Piece::Color)!color, board);
 	}
 }
 
@@ -50,12 +56,12 @@ void GameInfo::executeMove(const Move &move) {
 	castlingUnavailability |= CastlingMask[move.subject_from];
 	castlingUnavailability |= CastlingMask[move.subject_to];
 	// Clear en passant target.
-	enPassantTarget = 0;
+	enPassantTarget = -1;
 	if (move.type == Move::PAWN_DOUBLE_ADVANCE) {
-		enPassantTarget = move.subject;
+		enPassantTarget = move.subject_to;
 	}
 	// Reset fifty move rule counter if a pawn moved or a capture was made.
-	if (move.subject->type == Piece::PAWN || move.isCapture()) {
+	if (move.subject.type == Piece::PAWN || move.isCapture()) {
 		fiftyMoveRuleCounter = -1;
 	}
 	// Increment turn.
@@ -63,6 +69,16 @@ void GameInfo::executeMove(const Move &move) {
 	turn = (Piece::Color)!turn;
 	if (turn == Piece::WHITE) numTurns++;
 	inCheck = false;
+	updateHash();
+}
+
+void GameInfo::executeNullMove() {
+	enPassantTarget = -1;
+	fiftyMoveRuleCounter++;
+	turn = (Piece::Color)!turn;
+	if (turn == Piece::WHITE) numTurns++;
+	inCheck = false;
+	updateHash();
 }
 
 void GameInfo::reverseMove(const Irreversible &irreversible) {
@@ -70,6 +86,7 @@ void GameInfo::reverseMove(const Irreversible &irreversible) {
 	this->fiftyMoveRuleCounter = irreversible.fiftyMoveRuleCounter;
 	this->enPassantTarget = irreversible.enPassantTarget;
 	this->inCheck = irreversible.inCheck;
+	this->hash = irreversible.hash;
 	// Decrement turn.
 	if (turn == Piece::WHITE) numTurns--;
 	turn = (Piece::Color)!turn;
@@ -83,8 +100,7 @@ GameInfo::State GameInfo::updateState(Board *board, MoveList &moveList) {
 	State state = NORMAL;
 	// If king is under threat, we are in check.
 	if (MoveList::InCheck(turn, board)) inCheck = true;
-	moveList.generate(turn, board, this);
-	moveList.prune((Piece::Color)!turn, board);
+	moveList.generateLegal(turn, board, this);
 	// If there are no moves available, the game is either won or drawn.
 	if (moveList.empty()) {
 		if (inCheck) state = CHECKMATE;
@@ -93,4 +109,10 @@ GameInfo::State GameInfo::updateState(Board *board, MoveList &moveList) {
 	return state;
 }
 
+void GameInfo::updateHash() {
+	hash = Zobrist::Castling[castlingUnavailability] ^ Zobrist::FiftyMoveKey(fiftyMoveRuleCounter);
+	if (turn == Piece::BLACK) hash ^= Zobrist::Turn;
+	if (enPassantTarget >= 0) hash ^= Zobrist::EnPassant[Position::File(enPassantTarget)];
+}
+
 }
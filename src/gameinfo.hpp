@@ -6,6 +6,7 @@
 #include "movelist.hpp"
 #include "piece.hpp"
 #include "position.hpp"
+#include "zobrist.hpp"
 
 namespace ChessProject {
 
@@ -28,8 +29,9 @@ struct GameInfo {
 	struct Irreversible {
 		int castlingUnavailability;
 		int fiftyMoveRuleCounter;
-		Piece *enPassantTarget;
+		position enPassantTarget;
 		bool inCheck;
+		hashkey hash;
 		Irreversible(GameInfo *info);
 	};
 	// The castling mask is an 8 x 8 array representing positions on the board where castling availability is lost.
@@ -49,20 +51,27 @@ struct GameInfo {
 	int fiftyMoveRuleCounter;
 	// The color whose turn it is to move.
 	Piece::Color turn;
-	// If a pawn performs a double advance, it can be captured en passant. This member points to the piece that is now the en passant target.
-	// If no piece is the en passant target, this is set to null.
-	Piece *enPassantTarget;
+	// If a pawn performs a double advance, it can be captured en passant. This member holds the position of the pawn that is now the en
+	//passant target. If no piece is the en passant target, this is set to -1.
+	position enPassantTarget;
 	// Whether or not the game is in check.
 	bool inCheck;
+	// The Zobrist hash of the turn, castling unavailability, en passant target and fifty move rule counter. XOR with the board's hash to
+	//get the hash of the whole position.
+	hashkey hash;
 	void init();
 	// Returns true if the specified color can castle the specified side.
 	bool canCastle(Piece::Color color, Side side, Board *board);
 	// Update game info corresponding to this move and increment turn.
 	void executeMove(const Move &move);
+	// Passes the turn to the other color without moving a piece, for null move pruning. Taken back with reverseMove like any other move.
+	void executeNullMove();
 	// Take back a move. This method also requires extra parameters for members that cannot be restored.
 	void reverseMove(const Irreversible &irreversible);
 	// Updates the game state including whether or not the game has ended. Returns pruned move list for color now in play.
 	State updateState(Board *board, MoveList &moveList);
+	// Recalculates the hash from the current game info. Must be called after changing any of the hashed members directly.
+	void updateHash();
 };
 
 }
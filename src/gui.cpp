@@ -4,6 +4,8 @@
 namespace ChessProject {
 
 const std::string Gui::SpritesheetFilename = "res/spritesheet50x50.png";
+const std::string Gui::BookFilename = "res/book.bin";
+const std::string Gui::BitbaseDirectory = "res/bitbases";
 const double Gui::LightTileRed = 0.7;
 const double Gui::LightTileGreen = 0.7;
 const double Gui::LightTileBlue = 0.7;
@@ -15,13 +17,24 @@ const double Gui::HighlightPenalty = 0.5;
 
 Gui::Gui(Player white, Player black) :
 	movingFrom(-1),
-	finished(false) {
+	finished(false),
+	searching(NO_SEARCH),
+	searchDone(false),
+	stopRequested(false),
+	searchEval(0) {
 	players[Piece::WHITE] = white;
 	players[Piece::BLACK] = black;
 	board = new Board;
 	info = new GameInfo;
 	board->init();
 	info->init();
+	searchFinished.connect(sigc::mem_fun(*this, &Gui::onSearchFinished));
+}
+
+Gui::~Gui() {
+	cancelSearch();
+	delete board;
+	delete info;
 }
 
 bool Gui::init(Window *window) {
@@ -39,13 +52,21 @@ bool Gui::init(Window *window) {
 		std::cerr << "Error loading image: " << e.what() << std::endl;
 		return false;
 	}
+	// The book is optional, but one in the wrong format is reported rather than ignored.
+	Book::OpenResult bookResult = book.open(BookFilename);
+	if (bookResult == Book::OPENED) std::cout << "Opened opening book with " << book.size() << " entries" << std::endl;
+	else if (bookResult == Book::WRONG_FORMAT) std::cerr << BookFilename << " is not a book made by the book tool" << std::endl;
+	int numBitbases = Bitbase::Load(BitbaseDirectory);
+	if (numBitbases > 0) std::cout << "Loaded " << numBitbases << " endgame bitbases" << std::endl;
 	updateTurn();
 	return true;
 }
 
 void Gui::newGame() {
+	cancelSearch();
 	board->init();
 	info->init();
+	Minimax::Table.clear();
 	hintMove = Move();
 	movingFrom = -1;
 	finished = false;
@@ -56,11 +77,67 @@ void Gui::newGame() {
 }
 
 void Gui::hint() {
-	static const int depth = 4;
-	static const int quiescenceDepth = 8;
-	int eval = Minimax::AlphaBeta(board, info, hintMove, depth, quiescenceDepth);
-	std::cout << "How about move " << hintMove.toAlgebraic() << " with evaluation " << eval << std::endl;
+	if (finished) return;
+	startSearch(HINT_SEARCH, HintTime);
+}
+
+void Gui::stopSearch() {
+	// The worker thread still finishes normally, and the dispatcher delivers the move found so far.
+	if (searching != NO_SEARCH) stopRequested = true;
+}
+
+void Gui::startSearch(SearchType search, long time) {
+	if (searching != NO_SEARCH) return;
+	searching = search;
+	searchDone = false;
+	searchBoard = *board;
+	searchInfo = *info;
+	searchMove = Move();
+	stopRequested = false;
+	Minimax::Limits limits;
+	limits.time = time;
+	limits.stop = &stopRequested;
+	limits.threads = std::max(1u, std::thread::hardware_concurrency());
+	window->setStatus(search == MOVE_SEARCH ? "Thinking... (Stop / move now to play immediately)" : "Looking for a hint...");
+	searchThread = std::thread([this, limits]() {
+		searchEval = Minimax::Search(&searchBoard, &searchInfo, searchMove, limits);
+		searchDone = true;
+		searchFinished.emit();
+	});
+}
+
+void Gui::onSearchFinished() {
+	// The search may have been cancelled after it emitted.
+	if (!searchDone || !searchThread.joinable()) return;
+	searchThread.join();
+	SearchType search = searching;
+	searching = NO_SEARCH;
+	if (!searchMove.subject) {
+		updateTurn();
+		return;
+	}
+	if (search == MOVE_SEARCH) {
+		std::cout << "Executed move " << searchMove.toAlgebraic() << " with evaluation " << searchEval
+				  << " (depth " << Minimax::CompletedDepth() << ")" << std::endl;
+		board->executeMove(searchMove);
+		info->executeMove(searchMove);
+		hintMove = Move();
+	} else {
+		hintMove = searchMove;
+		std::cout << "How about move " << hintMove.toAlgebraic() << " with evaluation " << searchEval
+				  << " (depth " << Minimax::CompletedDepth() << ")" << std::endl;
+	}
+	std::cout << "Search statistics: " << Minimax::Statistics().toJson() << std::endl;
 	draw();
+	updateTurn();
+}
+
+void Gui::cancelSearch() {
+	if (!searchThread.joinable()) return;
+	stopRequested = true;
+	searchThread.join();
+	searching = NO_SEARCH;
+	searchDone = false;
 }
 
 void Gui::selectWhitePlayer() {
@@ -85,7 +162,7 @@ void Gui::selectBlackPlayer() {
 	updateTurn();
 }
 
-void Gui::draw(Piece *piece) {
+void Gui::draw(const Piece *piece) {
 	// The spritesheet is ordered to correlate with the Piece::Color and Piece::Type enums, so drawing from it is rather convenient.
 	spritesheet->render_to_drawable(get_window(), get_style()->get_black_gc(), piece->type * TileSize, piece->color * TileSize,
 		Position::File(piece->pos) * TileSize, (NUM_RANKS - 1 - Position::Rank(piece->pos)) * TileSize, TileSize, TileSize,
@@ -122,16 +199,19 @@ void Gui::updateTurn() {
 
 void Gui::doAiMove() {
 	if (finished) return;
-	Move move;
-	static const int depth = 3;
-	static const int quiescenceDepth = 8;
-	// AI searches game tree at specified depths to decide next move.
-	int eval = Minimax::AlphaBeta(board, info, move, depth, quiescenceDepth);
-	std::cout << "Executed move " << move.toAlgebraic() << " with evaluation " << eval << std::endl;
-	board->executeMove(move);
-	info->executeMove(move);
-	draw();
-	updateTurn();
+	// A book move is played straight away.
+	Move bookMove;
+	if (book.probe(board, info, bookMove)) {
+		std::cout << "Executed book move " << bookMove.toAlgebraic() << std::endl;
+		board->executeMove(bookMove);
+		info->executeMove(bookMove);
+		hintMove = Move();
+		draw();
+		updateTurn();
+		return;
+	}
+	// AI searches game tree as deeply as it can in the time given to decide next move.
+	startSearch(MOVE_SEARCH, AiMoveTime);
 }
 
 void Gui::draw() {
@@ -165,17 +245,16 @@ void Gui::draw() {
 		context->fill();
 	}
 	// Draw pieces.
-	for (int color = 0; color < 2; color++) {
-		for (PieceList::const_iterator pieceItr = board->firstPieceItr((Piece::Color)color);
-			 pieceItr != board->endPieceItr((Piece::Color)color); pieceItr++) {
-			draw(*pieceItr);
-		}
+	for (position pos = 0; pos < BOARDSIZE; pos++) {
+		const Piece *piece = board->getPiece(pos);
+		if (piece) draw(piece);
 	}
 }
 
 bool Gui::handleEvent(GdkEvent *event) {
 	if (event->type == Gdk::EXPOSE) draw();
-	if (finished) return true;
+	// The board can't change while a search is running.
+	if (finished || searching != NO_SEARCH) return true;
 	if (event->type == Gdk::BUTTON_PRESS) {
 		if (players[info->turn] == AI) {
 			doAiMove();
@@ -189,7 +268,6 @@ bool Gui::handleEvent(GdkEvent *event) {
 			std::cout << "Moving from..." << std::endl;
 			if (moveList.generateForHuman(pos, board, info)) {
 				std::cout << "Legal piece to move!" << std::endl;
-				moveList.prune((Piece::Color)!info->turn, board);
 				movingFrom = pos;
 				// Draw highlighted moves.
 				draw();
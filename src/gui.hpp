@@ -1,11 +1,16 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <iostream>
+#include <thread>
+#include <glibmm/dispatcher.h>
 #include <gtkmm/messagedialog.h>
 #include <gtkmm/drawingarea.h>
 #include <gtkmm/statusbar.h>
+#include "bitbase.hpp"
 #include "board.hpp"
+#include "book.hpp"
 #include "gameinfo.hpp"
 #include "minimax.hpp"
 #include "movelist.hpp"
@@ -24,6 +29,10 @@ class Gui : public Gtk::DrawingArea {
 public:
 	// The filename of the piece spritesheet.
 	static const std::string SpritesheetFilename;
+	// The filename of the opening book. The AI plays from it while the game is in the book, and searches once it isn't. The book is optional.
+	static const std::string BookFilename;
+	// The directory of the endgame bitbases, which make the AI play the endgames they cover perfectly. They are optional too.
+	static const std::string BitbaseDirectory;
 	// Size of each tile in pixels.
 	static const int TileSize = 50;
 	// The color values of light/dark tiles on the board.
@@ -31,13 +40,19 @@ public:
 	static const double DarkTileRed, DarkTileGreen, DarkTileBlue;
 	// If a selected piece can move to a tile, the tile is highlighted by multiplying the color value of the tile with these constants.
 	static const double HighlightBonus, HighlightPenalty;
+	// The time in milliseconds that the AI spends thinking about a move or a hint.
+	static const long AiMoveTime = 2000;
+	static const long HintTime = 3000;
 	Gui(Player white, Player black);
+	~Gui();
 	// Initialize the gui.
 	bool init(Window *window);
 	// Start a new game.
 	void newGame();
-	// Suggest a move for the player. Highlight the move on the board.
+	// Suggest a move for the player. Highlight the move on the board once the search has finished.
 	void hint();
+	// Stops a running search. The AI plays (or hints) the best move it has found so far.
+	void stopSearch();
 	// Launch the player selection dialog.
 	void selectWhitePlayer();
 	void selectBlackPlayer();
@@ -45,6 +60,7 @@ private:
 	Window *window;
 	// Sprite sheet image.
 	Glib::RefPtr<Gdk::Pixbuf> spritesheet;
+	Book book;
 	Board *board;
 	GameInfo *info;
 	Player players[NUM_COLORS];
@@ -56,11 +72,37 @@ private:
 	MoveList moveList;
 	// If the user has requested a hint, the hint is stored to this move. The hint is highlighted on the board.
 	Move hintMove;
+	// What a background search is for.
+	enum SearchType {
+		NO_SEARCH,
+		MOVE_SEARCH,
+		HINT_SEARCH
+	};
+	// Searches run on a worker thread, so that the window keeps responding while the AI thinks. The worker searches its own copy of the
+	//position, and the result is passed back to the main loop through the dispatcher.
+	SearchType searching;
+	std::thread searchThread;
+	// Set by the worker thread once its result is ready. A dispatcher signal without it is left over from a cancelled search.
+	std::atomic<bool> searchDone;
+	// Stops the worker's search. Cleared whenever a search starts, so a stop arriving after the worker has finished can't cut the next
+	//search short.
+	std::atomic<bool> stopRequested;
+	Glib::Dispatcher searchFinished;
+	Board searchBoard;
+	GameInfo searchInfo;
+	Move searchMove;
+	int searchEval;
+	// Starts searching the current position on the worker thread. Does nothing if a search is already running.
+	void startSearch(SearchType search, long time);
+	// Called on the main loop when the worker thread has finished. Plays or shows the move found.
+	void onSearchFinished();
+	// Stops any running search and waits for the worker thread, throwing its result away.
+	void cancelSearch();
 	// Draw a piece from the sprite sheet onto the window.
-	void draw(Piece *piece);
+	void draw(const Piece *piece);
 	// Update the turn
 	void updateTurn();
-	// Perform AI move.
+	// Start searching for an AI move. The move is performed when the search finishes.
 	void doAiMove();
 	// Draw board.
 	void draw();
@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <glibmm/thread.h>
 #include <gtkmm/main.h>
 #include <gtkmm/eventbox.h>
 #include <gtkmm/window.h>
@@ -9,6 +10,9 @@ using namespace ChessProject;
 
 int main(int argc, char **argv) {
 	Bitboard::Precalculate();
+	Zobrist::Precalculate();
+	// Searches report back to the main loop from a worker thread, which needs GLib's thread support.
+	if (!Glib::thread_supported()) Glib::thread_init();
 	Gtk::Main kit(argc, argv);
 	Window window;
 	if (!window.init()) {
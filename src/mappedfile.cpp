@@ -0,0 +1,49 @@
+#include "mappedfile.hpp"
+
+namespace ChessProject {
+
+MappedFile::MappedFile() :
+	bytes(0),
+	numBytes(0) { }
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const std::string &path) {
+	close();
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat status;
+	if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+	void *mapped = mmap(0, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	// The mapping stays valid once the file is closed.
+	::close(fd);
+	if (mapped == MAP_FAILED) return false;
+	bytes = (const unsigned char*)mapped;
+	numBytes = status.st_size;
+	return true;
+}
+
+void MappedFile::close() {
+	if (bytes) munmap((void*)bytes, numBytes);
+	bytes = 0;
+	numBytes = 0;
+}
+
+bool MappedFile::isOpen() const {
+	return bytes != 0;
+}
+
+const unsigned char* MappedFile::data() const {
+	return bytes;
+}
+
+std::size_t MappedFile::size() const {
+	return numBytes;
+}
+
+}
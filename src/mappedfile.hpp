@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ChessProject {
+
+// A read-only file mapped into memory. Pages are only read from disk when they are first touched, so opening even a large file is
+//immediate, and every process using the same file shares one copy of it.
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+	// Maps a file, closing any file already mapped. Returns false if the file can't be opened or is empty.
+	bool open(const std::string &path);
+	void close();
+	bool isOpen() const;
+	const unsigned char* data() const;
+	// Size of the file in bytes.
+	std::size_t size() const;
+private:
+	// A mapping can't be shared between two owners.
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+	const unsigned char *bytes;
+	std::size_t numBytes;
+};
+
+}
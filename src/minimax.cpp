@@ -2,66 +2,363 @@
 
 namespace ChessProject {
 
-const int Minimax::CenterSquares[NUM_CENTER_SQUARES] = { 27, 28, 35, 36 };
+TranspositionTable Minimax::Table;
+thread_local Minimax::SearchState *Minimax::Current = 0;
+int Minimax::LastDepth = 0;
+unsigned long Minimax::LastNodes = 0;
+SearchStats Minimax::LastStats;
+std::mutex Minimax::LastMutex;
+thread_local unsigned long Minimax::ThreadNodes = 0;
+thread_local SearchStats Minimax::ThreadStats;
+thread_local std::vector<MoveList> Minimax::MoveStack;
+thread_local Move Minimax::CurrentLine[MAX_PLY];
+const int &Minimax::CenterControlBonus = EvalParams::Weights[EvalParams::CENTER_CONTROL_BONUS];
 
-int Minimax::AlphaBeta(Board *board, GameInfo *gameInfo, Move &move, int depth, const int quiescenceDepth, int alpha, int beta) {
+Minimax::Limits::Limits() :
+	depth(MAX_DEPTH),
+	quiescenceDepth(8),
+	time(0),
+	nodes(0),
+	threads(1),
+	seePruning(true),
+	deltaMargin(200),
+	pvs(true),
+	aspirationWindow(50),
+	nullMove(true),
+	nullMoveReduction(2),
+	lmr(true),
+	lmrMinDepth(3),
+	lmrMinMoves(4),
+	lmrReduction(1),
+	stop(0) { }
+
+Minimax::SearchState::SearchState() :
+	stopped(false),
+	nodes(0),
+	depth(0) { }
+
+int Minimax::Search(Board *board, GameInfo *gameInfo, Move &move, const Limits &limits, const IterationCallback &onIteration,
+					SearchStats *stats) {
+	SearchState state;
+	state.limits = limits;
+	state.startTime = std::chrono::steady_clock::now();
+	state.stats.iterationNodes.push_back(0);
+	Current = &state;
+	ThreadNodes = 0;
+	ThreadStats.clear();
+	MovePicker::ClearKillers();
+	int maxDepth = std::min(std::max(limits.depth, 1), MAX_DEPTH);
+	// Every helper thread gets its own copy of the position to search.
+	int numHelpers = std::max(limits.threads, 1) - 1;
+	std::vector<Board> helperBoards(numHelpers, *board);
+	std::vector<GameInfo> helperInfos(numHelpers, *gameInfo);
+	std::vector<std::thread> helpers;
+	for (int i = 0; i < numHelpers; i++) {
+		helpers.push_back(std::thread(HelperSearch, &state, &helperBoards[i], &helperInfos[i], i + 1, maxDepth, limits.quiescenceDepth));
+	}
+	int eval = 0;
+	Move bestMove;
+	for (int depth = 1; depth <= maxDepth; depth++) {
+		unsigned long nodesBefore = ThreadStats.nodes + ThreadStats.quiescenceNodes;
+		int alpha = -LARGEST_NUM, beta = LARGEST_NUM;
+		int window = limits.aspirationWindow;
+		if (window > 0 && depth >= AspirationMinDepth) {
+			alpha = std::max(eval - window, -LARGEST_NUM);
+			beta = std::min(eval + window, LARGEST_NUM);
+		}
+		Move iterationMove;
+		int iterationEval;
+		while (true) {
+			// The iteration starts with the best move of the last one, so the root move list is ordered by the previous iteration's result.
+			iterationMove = bestMove;
+			iterationEval = AlphaBeta(board, gameInfo, iterationMove, depth, limits.quiescenceDepth, alpha, beta);
+			if (state.stopped) break;
+			// If the score is outside the window, it is only a bound. Widen the side that failed, twice as far each time, and search again.
+			if (iterationEval <= alpha && alpha > -LARGEST_NUM) {
+				alpha = std::max(alpha - window, -LARGEST_NUM);
+			} else if (iterationEval >= beta && beta < LARGEST_NUM) {
+				beta = std::min(beta + window, LARGEST_NUM);
+			} else {
+				break;
+			}
+			window *= 2;
+			ThreadStats.aspirationResearches++;
+		}
+		// An iteration that was stopped part way through is discarded, as not every root move has been searched.
+		if (state.stopped) break;
+		eval = iterationEval;
+		bestMove = iterationMove;
+		state.depth = depth;
+		state.stats.iterationNodes.push_back(ThreadStats.nodes + ThreadStats.quiescenceNodes - nodesBefore);
+		// Add this thread's uncounted nodes to the total, so that NodeCount is up to date in the callback.
+		FlushNodes();
+		if (onIteration) onIteration(depth, eval, bestMove);
+		if (limits.stop && *limits.stop) break;
+		// Each iteration takes several times longer than the last, so if over half the time has been used, the next one won't finish.
+		if (limits.time > 0 && Elapsed() * 2 > limits.time) break;
+	}
+	// Stop and wait for the helpers. Their results are already in the transposition table.
+	state.stopped = true;
+	for (std::vector<std::thread>::iterator helperItr = helpers.begin(); helperItr != helpers.end(); helperItr++) {
+		helperItr->join();
+	}
+	FlushNodes();
+	state.stats.add(ThreadStats);
+	state.stats.time = Elapsed();
+	if (stats) *stats = state.stats;
+	{
+		std::lock_guard<std::mutex> lock(LastMutex);
+		LastDepth = state.depth;
+		LastNodes = state.nodes;
+		LastStats = state.stats;
+	}
+	Current = 0;
+	move = bestMove;
+	return eval;
+}
+
+int Minimax::CompletedDepth() {
+	if (Current) return Current->depth;
+	std::lock_guard<std::mutex> lock(LastMutex);
+	return LastDepth;
+}
+
+unsigned long Minimax::NodeCount() {
+	if (Current) return Current->nodes;
+	std::lock_guard<std::mutex> lock(LastMutex);
+	return LastNodes;
+}
+
+SearchStats Minimax::Statistics() {
+	// Another search may finish and overwrite the statistics at any time, so they are copied out under the lock.
+	std::lock_guard<std::mutex> lock(LastMutex);
+	return LastStats;
+}
+
+void Minimax::CountNode() {
+	if (++ThreadNodes < LimitCheckInterval) return;
+	FlushNodes();
+	// The first iteration always completes, so that there is always a move to play.
+	if (Current->depth == 0) return;
+	// A stop request is picked up here within LimitCheckInterval nodes.
+	if ((Current->limits.stop && *Current->limits.stop) || (Current->limits.nodes > 0 && Current->nodes >= Current->limits.nodes) ||
+		(Current->limits.time > 0 && Elapsed() >= Current->limits.time)) {
+		Current->stopped = true;
+	}
+}
+
+MoveList& Minimax::MovesAt(int ply) {
+	if (MoveStack.empty()) MoveStack.resize(MAX_PLY);
+	return MoveStack[ply];
+}
+
+void Minimax::FlushNodes() {
+	Current->nodes += ThreadNodes;
+	ThreadNodes = 0;
+}
+
+void Minimax::HelperSearch(SearchState *state, Board *board, GameInfo *gameInfo, int id, int maxDepth, int quiescenceDepth) {
+	Current = state;
+	ThreadNodes = 0;
+	ThreadStats.clear();
+	MovePicker::ClearKillers();
+	for (int depth = 1 + id % 2; depth <= maxDepth && !state->stopped; depth++) {
+		Move move;
+		AlphaBeta(board, gameInfo, move, depth, quiescenceDepth);
+	}
+	FlushNodes();
+	std::lock_guard<std::mutex> lock(state->statsMutex);
+	state->stats.add(ThreadStats);
+}
+
+long Minimax::Elapsed() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - Current->startTime).count();
+}
+
+int Minimax::ScoreToTable(int score, int ply) {
+	if (score >= MATE_BOUND && score <= LARGE_NUM) return score + ply;
+	if (score <= -MATE_BOUND && score >= -LARGE_NUM) return score - ply;
+	return score;
+}
+
+int Minimax::ScoreFromTable(int score, int ply) {
+	if (score >= MATE_BOUND && score <= LARGE_NUM) return score - ply;
+	if (score <= -MATE_BOUND && score >= -LARGE_NUM) return score + ply;
+	return score;
+}
+
+int Minimax::AlphaBeta(Board *board, GameInfo *gameInfo, Move &move, int depth, const int quiescenceDepth, int alpha, int beta, int ply,
+					   bool allowNullMove) {
 	// If we are at the end of the normal alpha beta search, perform a quiescence search with the given quiescence depth.
-	if (depth == 0) return Quiescence(board, gameInfo, quiescenceDepth, alpha, beta);
-	MoveList moveList;
-	// Generate move list and check game state.
-	GameInfo::State state = gameInfo->updateState(board, moveList);
-	switch (state) {
-		case GameInfo::STALEMATE:
-		case GameInfo::FIFTY_MOVE_RULE:
-		// Returns a score which will always be disregarded.
-		return LARGEST_NUM + 1;
-		case GameInfo::CHECKMATE:
-		// Return arbitrarily large negative score (But not -LARGEST_NUM, as it would be cut off).
-		return -LARGE_NUM;
+	if (depth == 0) return Quiescence(board, gameInfo, quiescenceDepth, alpha, beta, ply);
+	CountNode();
+	ThreadStats.nodes++;
+	// If this position has already been searched deeply enough, reuse the result. The root always searches, as it has to return a move.
+	hashkey hash = board->getHash() ^ gameInfo->hash;
+	TranspositionTable::Entry entry;
+	bool hashHit = Table.probe(hash, entry);
+	if (hashHit) entry.score = ScoreFromTable(entry.score, ply);
+	int hashScore;
+	if (ply > 0 && hashHit && TranspositionTable::CanCutoff(entry, depth, alpha, beta, hashScore)) return hashScore;
+	// A draw by insufficient material or the fifty move rule returns a score which will always be disregarded. Checkmate and stalemate are
+	//found once the moves have run out. The root is still searched, as a move has to be played even if the position is already drawn.
+	if (ply > 0 && (board->insufficientMaterial() || gameInfo->fiftyMoveRuleCounter >= 100)) return LARGEST_NUM + 1;
+	// The result of a bitbase endgame is already known. The root still searches, so that it can pick the move that mates soonest.
+	int bitbaseScore;
+	if (ply > 0 && Bitbase::Probe(board, gameInfo, bitbaseScore)) {
+		ThreadStats.bitbaseHits++;
+		return bitbaseScore;
 	}
-	MoveList::iterator bestMoveItr = moveList.begin();
-	for (MoveList::iterator moveItr = moveList.begin(); moveItr != moveList.end(); moveItr++) {
-		Move childMove = *moveItr;
+	gameInfo->inCheck = MoveList::InCheck(gameInfo->turn, board);
+	// Give the opponent a free move. If our position is still at least beta, a real move would almost certainly do better, so cut off.
+	Piece::Color turn = gameInfo->turn;
+	bitboard64 pieces = board->getPieces(turn, Piece::KNIGHT) | board->getPieces(turn, Piece::BISHOP) |
+						board->getPieces(turn, Piece::ROOK) | board->getPieces(turn, Piece::QUEEN);
+	if (Current->limits.nullMove && allowNullMove && ply > 0 && !gameInfo->inCheck && pieces && !board->isEndGame() &&
+		depth > Current->limits.nullMoveReduction && beta < MATE_BOUND && Eval(board, gameInfo) >= beta) {
+		GameInfo::Irreversible irreversible(gameInfo);
+		gameInfo->executeNullMove();
+		CurrentLine[ply] = Move();
+		Move nullBestMove;
+		int nullEval = -AlphaBeta(board, gameInfo, nullBestMove, depth - 1 - Current->limits.nullMoveReduction, quiescenceDepth,
+								  -beta, -beta + 1, ply + 1, false);
+		gameInfo->reverseMove(irreversible);
+		if (Current->stopped) return 0;
+		if (nullEval >= beta) {
+			ThreadStats.nullMoveCutoffs++;
+			return beta;
+		}
+	}
+	// Search the best move from a previous search of this position first, as it is the most likely to cause a cutoff. At the root, the move
+	//passed in takes priority, so that iterative deepening always searches its best move first.
+	Move hashMove;
+	if (ply == 0 && move.subject) {
+		hashMove = move;
+	} else if (hashHit) {
+		hashMove.subject_from = entry.bestFrom;
+		hashMove.subject_to = entry.bestTo;
+		hashMove.type = (Move::Type)entry.bestType;
+	}
+	const Move &previousMove = ply > 0 ? CurrentLine[ply - 1] : Move();
+	MovePicker picker(board, gameInfo, MovesAt(ply), hashMove, ply, previousMove);
+	const int originalAlpha = alpha;
+	Move childMove, bestMove;
+	int movesSearched = 0;
+	bool canReduce = Current->limits.lmr && depth >= Current->limits.lmrMinDepth && !gameInfo->inCheck;
+	while (picker.next(childMove)) {
+		bool firstMove = (movesSearched++ == 0);
+		if (firstMove) bestMove = childMove;
+		CurrentLine[ply] = childMove;
 		board->executeMove(childMove);
 		// Save any irreversible game info before making a move.
 		GameInfo::Irreversible irreversible(gameInfo);
 		gameInfo->executeMove(childMove);
 		// Here, the child's evaluation is taken to be the negation of its return value, so that seperate if statements for maximising and minimising
 		//aren't required.
-		int childEval = -AlphaBeta(board, gameInfo, move, depth - 1, quiescenceDepth, -beta, -alpha);
+		Move childBestMove;
+		int childEval = 0;
+		bool fullDepth = true;
+		// Moves this late in the ordering rarely turn out best, so quiet ones that don't give check are searched shallower first. Killers and
+		//countermoves are never reduced.
+		if (canReduce && movesSearched > Current->limits.lmrMinMoves && picker.stage() == MovePicker::QUIETS &&
+			!MoveList::InCheck(gameInfo->turn, board)) {
+			ThreadStats.reductions++;
+			int reducedDepth = std::max(depth - 1 - Current->limits.lmrReduction, 0);
+			childEval = -AlphaBeta(board, gameInfo, childBestMove, reducedDepth, quiescenceDepth, -alpha - 1, -alpha, ply + 1);
+			fullDepth = childEval > alpha && !Current->stopped;
+			if (fullDepth) ThreadStats.lmrResearches++;
+		}
+		if (fullDepth && (!Current->limits.pvs || firstMove)) {
+			childEval = -AlphaBeta(board, gameInfo, childBestMove, depth - 1, quiescenceDepth, -beta, -alpha, ply + 1);
+		} else if (fullDepth) {
+			// Later moves are expected to be worse than the first, which a null window search proves more cheaply.
+			childEval = -AlphaBeta(board, gameInfo, childBestMove, depth - 1, quiescenceDepth, -alpha - 1, -alpha, ply + 1);
+			if (childEval > alpha && childEval < beta && !Current->stopped) {
+				ThreadStats.pvsResearches++;
+				childEval = -AlphaBeta(board, gameInfo, childBestMove, depth - 1, quiescenceDepth, -beta, -alpha, ply + 1);
+			}
+		}
 		board->reverseMove(childMove);
 		gameInfo->reverseMove(irreversible);
+		// The child's evaluation is meaningless if the search was stopped, so unwind without storing anything.
+		if (Current->stopped) return 0;
 		// If the child evaluates to a score greater than or equal to beta, there is a beta cutoff. This means that there is no further point exploring this
 		// node's moves, as it is known that this node will at least be as bad if not worse than another node elsewhere in the game tree.
 		if (childEval >= beta) {
 			// If a non-capture move caused a beta-cutoff, increase its history weighting. The depth squared is added to the heuristic so that moves near
 			//the leaf nodes don't dominate the heuristic (Leaf node score would be 0 * 0).
-			if (!move.isCapture()) Move::HistoryHeuristic[move.subject_from][move.subject_to] += depth * depth;
-			move = *bestMoveItr;
+			//Quiet moves are also remembered as killers and countermoves.
+			if (!childMove.isCapture()) Move::HistoryHeuristic[childMove.subject_from][childMove.subject_to] += depth * depth;
+			if (!childMove.isCapture() && childMove.type < Move::PROMOTION) MovePicker::StoreCutoff(childMove, ply, previousMove);
+			ThreadStats.betaCutoffs++;
+			if (firstMove) ThreadStats.firstMoveCutoffs++;
+			move = childMove;
+			Table.store(hash, depth, ScoreToTable(beta, ply), TranspositionTable::LOWER, move);
 			return beta;
 		}
 		// If the child's evaluation is greater than alpha, this is the best move at the moment.
 		if (childEval > alpha) {
 			alpha = childEval;
-			bestMoveItr = moveItr;
+			bestMove = childMove;
 		}
 	}
-	move = *bestMoveItr;
+	if (movesSearched == 0) {
+		// Checkmate returns a large negative score (But not -LARGEST_NUM, as it would be cut off), less negative the further it is from the
+		//root, so that the quickest mate is preferred. Stalemate is disregarded.
+		return gameInfo->inCheck ? -LARGE_NUM + ply : LARGEST_NUM + 1;
+	}
+	move = bestMove;
+	// If no move raised alpha, the real score of this node is at most alpha, and there is no reliable best move to store.
+	if (alpha > originalAlpha) Table.store(hash, depth, ScoreToTable(alpha, ply), TranspositionTable::EXACT, move);
+	else Table.store(hash, depth, ScoreToTable(alpha, ply), TranspositionTable::UPPER, Move());
 	return alpha;
 }
 
-int Minimax::Quiescence(Board *board, GameInfo *gameInfo, int depth, int alpha, int beta) {
+int Minimax::Quiescence(Board *board, GameInfo *gameInfo, int depth, int alpha, int beta, int ply) {
+	CountNode();
+	ThreadStats.quiescenceNodes++;
+	ThreadStats.maxQuiescenceDepth = std::max(ThreadStats.maxQuiescenceDepth, Current->limits.quiescenceDepth - depth);
+	// The move stack has run out. This can only happen with a very large quiescence depth.
+	if (ply >= MAX_PLY) return Eval(board, gameInfo);
+	// Quiescence results are stored with a depth of 0, so any stored result of this position can be used.
+	hashkey hash = board->getHash() ^ gameInfo->hash;
+	TranspositionTable::Entry entry;
+	bool hashHit = Table.probe(hash, entry);
+	if (hashHit) entry.score = ScoreFromTable(entry.score, ply);
+	int hashScore;
+	if (hashHit && TranspositionTable::CanCutoff(entry, 0, alpha, beta, hashScore)) return hashScore;
 	// Evaluate the node in its current state. If it causes a beta-cutoff, assume that there will be no move further down the
 	//game tree that will result in a better evaluation. Otherwise, set it as the lower bound, alpha.
 	int nodeEvaluation = Eval(board, gameInfo);
 	if (nodeEvaluation >= beta) return beta;
+	const int originalAlpha = alpha;
 	if (nodeEvaluation > alpha) alpha = nodeEvaluation;
-	MoveList moveList;
-	// If the node is in check, consider every move. Otherwise, just consider captures/promotions.
-	moveList.generate(gameInfo->turn, board, gameInfo, !MoveList::InCheck(gameInfo->turn, board));
-	moveList.prune((Piece::Color)!gameInfo->turn, board);
-	for (MoveList::iterator moveItr = moveList.begin(); moveItr != moveList.end(); moveItr++) {
-		Move move = *moveItr;
+	// Just consider captures/promotions, unless the node is in check, in which case every evasion is generated.
+	gameInfo->inCheck = MoveList::InCheck(gameInfo->turn, board);
+	Move hashMove;
+	if (hashHit) {
+		hashMove.subject_from = entry.bestFrom;
+		hashMove.subject_to = entry.bestTo;
+		hashMove.type = (Move::Type)entry.bestType;
+	}
+	MovePicker picker(board, gameInfo, MovesAt(ply), hashMove);
+	// Delta pruning is not safe in the endgame, where a single capture can decide the game.
+	bool deltaPruning = Current->limits.deltaMargin > 0 && !gameInfo->inCheck && !board->isEndGame();
+	Move move, bestMove;
+	while (picker.next(move)) {
+		if (!gameInfo->inCheck) {
+			// A capture that loses material by static exchange evaluation is very unlikely to restore a quiet position that is good for us.
+			if (Current->limits.seePruning && picker.stage() == MovePicker::BAD_CAPTURES) {
+				ThreadStats.seePrunes++;
+				continue;
+			}
+			// If winning the captured piece, plus a margin for positional gains, can't raise the stand pat score to alpha, don't search it.
+			if (deltaPruning && move.type < Move::PROMOTION &&
+				nodeEvaluation + Piece::MaterialWorth[move.object.type] + Current->limits.deltaMargin <= alpha) {
+				ThreadStats.deltaPrunes++;
+				continue;
+			}
+		}
 		board->executeMove(move);
 		// Save any irreversible game info before making a move.
 		GameInfo::Irreversible irreversible(gameInfo);
@@ -69,28 +366,39 @@ int Minimax::Quiescence(Board *board, GameInfo *gameInfo, int depth, int alpha,
 		int childEval = 0;
 		// If we are at depth 0, just get the score of the board (The score is negated as it is measured relative to the opposite color).
 		if (depth == 0) childEval = -Eval(board, gameInfo);
-		else childEval = -Quiescence(board, gameInfo, depth - 1, -beta, -alpha);
+		else childEval = -Quiescence(board, gameInfo, depth - 1, -beta, -alpha, ply + 1);
 		board->reverseMove(move);
 		gameInfo->reverseMove(irreversible);
-		if (childEval >= beta) return beta;
-		if (childEval > alpha) alpha = childEval;
+		if (Current->stopped) return 0;
+		if (childEval >= beta) {
+			Table.store(hash, 0, ScoreToTable(beta, ply), TranspositionTable::LOWER, move);
+			return beta;
+		}
+		if (childEval > alpha) {
+			alpha = childEval;
+			bestMove = move;
+		}
 	}
+	Table.store(hash, 0, ScoreToTable(alpha, ply), alpha > originalAlpha ? TranspositionTable::EXACT : TranspositionTable::UPPER, bestMove);
 	return alpha;
 }
 
 int Minimax::Eval(Board *board, GameInfo *gameInfo) {
 	// If the game cannot be won from this board, return a dismissable score.
 	if (board->isEndGame() && board->insufficientMaterial()) return LARGEST_NUM + 1;
+	int bitbaseScore;
+	if (Bitbase::Probe(board, gameInfo, bitbaseScore)) {
+		ThreadStats.bitbaseHits++;
+		return bitbaseScore;
+	}
 	int eval = 0;
 	// Evaluate number of pieces left on each side.
 	eval += board->materialEval(gameInfo->turn);
 	// Pawn structure evaluations.
 	eval += board->pawnEval(gameInfo->turn);
 	// Add a bonus to a side for being able to attack the center squares.
-	for (int i = 0; i < NUM_CENTER_SQUARES; i++) {
-		if (MoveList::UnderThreat(CenterSquares[i], gameInfo->turn, board)) eval += CenterControlBonus;
-		if (MoveList::UnderThreat(CenterSquares[i], (Piece::Color)!gameInfo->turn, board)) eval -= CenterControlBonus;
-	}
+	eval += CenterControlBonus * (__builtin_popcountll(board->getAttacks(gameInfo->turn) & CenterSquares) -
+								  __builtin_popcountll(board->getAttacks((Piece::Color)!gameInfo->turn) & CenterSquares));
 	return eval;
 }
 
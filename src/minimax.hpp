@@ -1,35 +1,160 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bitbase.hpp"
 #include "board.hpp"
+#include "evalparams.hpp"
 #include "gameinfo.hpp"
 #include "move.hpp"
 #include "movelist.hpp"
+#include "movepicker.hpp"
+#include "searchstats.hpp"
+#include "transposition.hpp"
 
 #define LARGEST_NUM 1000000
 #define LARGE_NUM 100000
-#define NUM_CENTER_SQUARES 4
+// Checkmate scores LARGE_NUM less the plies from the root to the mate, so any score at least MATE_BOUND is a forced mate.
+#define MATE_BOUND (LARGE_NUM - MAX_PLY)
+// The deepest an iterative deepening search will go.
+#define MAX_DEPTH 64
 
 namespace ChessProject {
 
 class Minimax {
 public:
-	// Recursively evaluates board to a given depth using alpha-beta pruning.
+	// The budget for a search. Any limit set to 0 is ignored, and the search stops when the first of the other limits is reached.
+	struct Limits {
+		// Maximum depth of the main search, not including quiescence.
+		int depth;
+		int quiescenceDepth;
+		// Wall-clock time in milliseconds.
+		long time;
+		// Total number of nodes searched, including quiescence nodes.
+		unsigned long nodes;
+		// Number of threads searching the position. Must be at least 1.
+		int threads;
+		// Quiescence search skips captures that lose material by static exchange evaluation.
+		bool seePruning;
+		// Quiescence search skips captures that can't raise the stand pat score to alpha even with this much positional gain on top of the
+		//captured piece (delta pruning). Set to 0 to search every capture.
+		int deltaMargin;
+		// Principal variation search. Every move after the first is searched with a null window, which only proves that it is no better
+		//than the best so far. Only a move that turns out to be better is searched again with the full window.
+		bool pvs;
+		// Half the width of the root aspiration window. From AspirationMinDepth on, each iteration is searched with a window centred on the
+		//score of the last one, and the window is widened and searched again if the score falls outside it. Set to 0 to always search the
+		//root with the full window.
+		int aspirationWindow;
+		// Null move pruning. If passing the turn still leaves a position too good for the opponent to allow, searched nullMoveReduction plies
+		//shallower than normal, the node is cut off without searching any moves. It is not tried in check, in the endgame or without pieces
+		//other than pawns, where passing may be the best move (zugzwang) and the cutoff would be wrong.
+		bool nullMove;
+		int nullMoveReduction;
+		// Late move reductions. Quiet moves ordered after the first lmrMinMoves moves at nodes at least lmrMinDepth deep are first searched
+		//lmrReduction plies shallower with a null window. Only a move that beats alpha anyway is searched again at full depth.
+		bool lmr;
+		int lmrMinDepth;
+		int lmrMinMoves;
+		int lmrReduction;
+		// Set by another thread to stop the search early, which then returns the result of its last completed iteration. The flag belongs
+		//to the caller and is only read, so a stop never carries over to a later search. Null if the search is never stopped this way.
+		const std::atomic<bool> *stop;
+		Limits();
+	};
+	// Called by the main search thread after every completed iteration with its depth, score and best move.
+	typedef std::function<void(int depth, int score, const Move &move)> IterationCallback;
+	// Results of previously searched positions. Shared by every search.
+	static TranspositionTable Table;
+	// Searches to depth 1, then 2, then 3 and so on until a limit is reached. Each iteration searches the previous iteration's best move first.
+	//The best move of the deepest completed iteration is stored in move, and its score is returned. At least depth 1 is always completed.
+	// With more than one thread, helper threads search copies of the position at the same time (Lazy SMP). They share nothing but the
+	//transposition table, and only help by filling it with results that the main thread can then cut off with.
+	// If stats is given, the statistics of the search are stored in it. Unlike Statistics(), which returns whichever search finished
+	//last, these are always from this search when several searches are running at once.
+	static int Search(Board *board, GameInfo *gameInfo, Move &move, const Limits &limits,
+					  const IterationCallback &onIteration = IterationCallback(), SearchStats *stats = 0);
+	// Returns the depth of the last completed iteration of the search running on the calling thread (such as from an iteration
+	//callback), or of the most recent search to finish if the thread isn't searching.
+	static int CompletedDepth();
+	// Returns the number of nodes visited so far by the search running on the calling thread, or by the most recent search to finish.
+	static unsigned long NodeCount();
+	// Returns a copy of the statistics of the most recent search to finish, from every thread.
+	static SearchStats Statistics();
+	// Recursively evaluates board to a given depth using alpha-beta pruning. The best move found is stored in move. The ply is the distance
+	//from the root of the search. At the root, a move passed in is searched first. A null move is never tried straight after another one.
 	static int AlphaBeta(Board *board, GameInfo *gameInfo, Move &move, int depth, const int quiescenceDepth,
 						 int alpha = -LARGEST_NUM,
-						 int beta = LARGEST_NUM);
+						 int beta = LARGEST_NUM,
+						 int ply = 0,
+						 bool allowNullMove = true);
 	// Searches through interesting moves. Only evaluates when a position is quiet, or when a certain depth has been reached.
-	static int Quiescence(Board *board, GameInfo *gameInfo, int depth, int alpha, int beta);
-private:
-	// The positions of the center squares of the board.
-	static const int CenterSquares[NUM_CENTER_SQUARES];
+	static int Quiescence(Board *board, GameInfo *gameInfo, int depth, int alpha, int beta, int ply);
+	// The center squares of the board (d4, e4, d5 and e5).
+	static const bitboard64 CenterSquares = 0x0000001818000000ULL;
 	// The bonus given to a team for attacking a center square.
-	static const int CenterControlBonus = 20;
-	// Evaluates the board. Includes the following evaluations:
+	static const int &CenterControlBonus;
+	// Evaluates the board relative to the side to move. Includes the following evaluations:
 	// 1 - Relative material worth + piece square bonuses.
 	// 2 - Backward/Doubled/Isolated/Passed pawn evaluation.
 	// 3 - Control of center squares.
 	// 4 - Rooks on semi-open/open files.
+	// Bitbase endgames are scored from the bitbase instead.
 	static int Eval(Board *board, GameInfo *gameInfo);
+private:
+	// Iterations shallower than this are cheap and have unstable scores, so they are searched with the full window.
+	static const int AspirationMinDepth = 4;
+	// Number of nodes between checks of the search limits. Reading the clock at every node would be too expensive.
+	static const unsigned long LimitCheckInterval = 1024;
+	// The state of one search, shared by its main thread and helpers. Each thread finds the search it is working on through Current, so
+	//separate searches (such as different positions being analysed in a batch) can run on different threads at the same time.
+	struct SearchState {
+		// The limits of the search. Only enforced once the first iteration is complete.
+		Limits limits;
+		std::chrono::steady_clock::time_point startTime;
+		// Set when the search has to be abandoned. Every node returns immediately once this is set.
+		std::atomic<bool> stopped;
+		// Nodes searched by all threads. Each thread counts its own nodes and adds them to the total every LimitCheckInterval nodes.
+		std::atomic<unsigned long> nodes;
+		std::atomic<int> depth;
+		// Helpers add their statistics to these under the mutex when they finish, and the main thread adds its own once they have.
+		SearchStats stats;
+		std::mutex statsMutex;
+		SearchState();
+	};
+	static thread_local SearchState *Current;
+	// The results of the most recent search to finish, for CompletedDepth, NodeCount and Statistics to return once it has.
+	static int LastDepth;
+	static unsigned long LastNodes;
+	static SearchStats LastStats;
+	static std::mutex LastMutex;
+	static thread_local unsigned long ThreadNodes;
+	// Every thread counts statistics into its own copy, and adds them to the search's once it is done.
+	static thread_local SearchStats ThreadStats;
+	// Every thread has a stack of move lists with one list per ply, allocated the first time the thread searches. Each node generates its
+	//moves into the list for its ply, so the search never allocates memory for moves.
+	static thread_local std::vector<MoveList> MoveStack;
+	// The moves that led from the root to the node being searched by the calling thread, by ply. Used to find countermoves.
+	static thread_local Move CurrentLine[MAX_PLY];
+	// Returns the calling thread's move list for the given ply.
+	static MoveList& MovesAt(int ply);
+	// Counts a node, and stops the search if a limit has been reached.
+	static void CountNode();
+	// Adds the nodes counted by this thread to the total.
+	static void FlushNodes();
+	// Runs iterative deepening on a helper thread until the main thread stops the search. Odd numbered helpers search one ply deeper than
+	//the main thread, so that the threads don't all search the same tree in lockstep.
+	static void HelperSearch(SearchState *state, Board *board, GameInfo *gameInfo, int id, int maxDepth, int quiescenceDepth);
+	// Milliseconds since the search started.
+	static long Elapsed();
+	// Mate scores are stored in the transposition table relative to the node rather than the root, as the same position can be reached at
+	//different plies.
+	static int ScoreToTable(int score, int ply);
+	static int ScoreFromTable(int score, int ply);
 };
 
 }
@@ -24,30 +24,34 @@ struct Move {
 		PROMOTION_QUEEN = PROMOTION + Piece::QUEEN,
 		PROMOTION_ROOK = PROMOTION + Piece::ROOK
 	};
-	// The history heuristic gives a penalty for a move in ordering if a move with the same source and destination has already been subject to beta cutoffs
-	//during alpha beta pruning.
-	static int HistoryHeuristic[BOARDSIZE][BOARDSIZE];
-	// Zero initializes history heuristic array.
+	// The history heuristic gives a bonus for a quiet move in ordering if a move with the same source and destination has already caused beta
+	//cutoffs during alpha beta pruning. Every search thread keeps its own history.
+	static thread_local int HistoryHeuristic[BOARDSIZE][BOARDSIZE];
+	// Zero initializes history heuristic array of the calling thread.
 	static void InitHistory();
-	// The piece moved is the subject.
-	Piece *subject;
+	// The piece moved is the subject. Pieces are stored by value, as they were before the move was made (a promoting pawn is still a pawn).
+	Piece subject;
 	position subject_from, subject_to;
 	// The object piece is any secondary piece that is being moved as a result of this move. This is used for two instances:
 	// 1 - If a piece was being captured (or en passanted), it would be the object being moved to a negative position.
 	// 2 - In the event of a castling, the object is the rook.
-	// If there is no object, it is set to null.
-	Piece *object;
+	// If there is no object, it is the null piece.
+	Piece object;
 	position object_from, object_to;
 	Type type;
 	// This is a weak evaluation of the move, such that moves can be ordered with better moves first. This improves the efficiency of alpha-beta pruning.
+	//It is 0 until the move is evaluated, which is only done for moves that are about to be ordered.
 	int weakEval;
 	Move();
-	Move(Piece *subject, position subject_from, position subject_to,
-		 Piece *object, position object_from, position object_to,
+	// The pieces are copied. A null object pointer means there is no object.
+	Move(const Piece *subject, position subject_from, position subject_to,
+		 const Piece *object, position object_from, position object_to,
 		 Type type);
+	// Sets the weak evaluation of the move.
+	void evaluate();
 	// Returns true if this move is a capture.
 	bool isCapture() const;
-	// Returns the string representation of the move in algebraic notation.
+	// Returns the string representation of the move in long algebraic notation (e.g. e2e4, e7e8q).
 	std::string toAlgebraic() const;
 };
 
@@ -3,15 +3,139 @@
 
 namespace ChessProject {
 
+const Piece::Type MoveList::ExchangeOrder[NUM_PIECE_TYPES] = {
+	Piece::PAWN, Piece::KNIGHT, Piece::BISHOP, Piece::ROOK, Piece::QUEEN, Piece::KING
+};
+
+MoveList::MoveList() :
+	count(0) { }
+
+MoveList::iterator MoveList::begin() {
+	return moves;
+}
+
+MoveList::iterator MoveList::end() {
+	return moves + count;
+}
+
+MoveList::const_iterator MoveList::begin() const {
+	return moves;
+}
+
+MoveList::const_iterator MoveList::end() const {
+	return moves + count;
+}
+
+bool MoveList::empty() const {
+	return count == 0;
+}
+
+int MoveList::size() const {
+	return count;
+}
+
+void MoveList::clear() {
+	count = 0;
+}
+
+void MoveList::insert(const Move &move) {
+	moves[count++] = move;
+}
+
+void MoveList::erase(iterator first) {
+	count = first - moves;
+}
+
+void MoveList::sort() {
+	for (int i = 0; i < count; i++) moves[i].evaluate();
+	// Move lists are short, so a simple insertion sort is fast, and unlike std::sort it is stable.
+	Move::Evaluator better;
+	for (int i = 1; i < count; i++) {
+		Move move = moves[i];
+		int j = i;
+		for (; j > 0 && better(move, moves[j - 1]); j--) moves[j] = moves[j - 1];
+		moves[j] = move;
+	}
+}
+
 void MoveList::generate(Piece::Color color, Board *board, GameInfo *info, bool onlyInteresting) {
-	for (PieceList::iterator pieceItr = board->firstPieceItr(color);
-		 pieceItr != board->endPieceItr(color); pieceItr++) {
-		Piece *piece = *pieceItr;
-		generate(*pieceItr, board, info, onlyInteresting);
+	bitboard64 targets = onlyInteresting ? board->getOccupied((Piece::Color)!color) : ~board->getOccupied(color);
+	bitboard64 occupied = board->getOccupied();
+	genPawnMoves(color, ~(bitboard64)0, board, info, true, !onlyInteresting);
+	for (bitboard64 knights = board->getPieces(color, Piece::KNIGHT); knights; ) {
+		position from = Bitboard::PopFirst(knights);
+		addMoves(board->getPiece(from), Bitboard::KnightAttacks[from] & targets, board);
 	}
+	for (bitboard64 bishops = board->getPieces(color, Piece::BISHOP); bishops; ) {
+		position from = Bitboard::PopFirst(bishops);
+		addMoves(board->getPiece(from), Bitboard::BishopAttacks(from, occupied) & targets, board);
+	}
+	for (bitboard64 rooks = board->getPieces(color, Piece::ROOK); rooks; ) {
+		position from = Bitboard::PopFirst(rooks);
+		addMoves(board->getPiece(from), Bitboard::RookAttacks(from, occupied) & targets, board);
+	}
+	for (bitboard64 queens = board->getPieces(color, Piece::QUEEN); queens; ) {
+		position from = Bitboard::PopFirst(queens);
+		addMoves(board->getPiece(from), (Bitboard::BishopAttacks(from, occupied) | Bitboard::RookAttacks(from, occupied)) & targets, board);
+	}
+	const Piece *king = board->getKing(color);
+	if (!king) return;
+	addMoves(king, Bitboard::KingAttacks[king->pos] & targets, board);
+	if (!onlyInteresting) {
+		// Castling
+		if (info->canCastle(color, GameInfo::KINGSIDE, board)) {
+			const Piece *rook = board->getPiece(king->pos + 3);
+			insert(Move(king, king->pos, king->pos + 2, rook, rook->pos, rook->pos - 2, Move::NORMAL));
+		}
+		if (info->canCastle(color, GameInfo::QUEENSIDE, board)) {
+			const Piece *rook = board->getPiece(king->pos - 4);
+			insert(Move(king, king->pos, king->pos - 2, rook, rook->pos, rook->pos + 3, Move::NORMAL));
+		}
+	}
+	sort();
+}
+
+void MoveList::generateLegal(Piece::Color color, Board *board, GameInfo *info, bool onlyInteresting) {
+	// Every evasion is generated when in check, even if only interesting moves were asked for.
+	bool inCheck = onlyInteresting && InCheck(color, board);
+	generateLegal(color, board, info, ~(bitboard64)0, true, !onlyInteresting || inCheck);
+	sort();
 }
 
-void MoveList::generate(Piece *piece, Board *board, GameInfo *info, bool onlyInteresting) {
+void MoveList::generateLegal(Piece::Color color, Board *board, GameInfo *info, bitboard64 sources, bool captures, bool quiets) {
+	const Piece *king = board->getKing(color);
+	bitboard64 checkers = AttackersOf(king->pos, (Piece::Color)!color, board->getOccupied(), board);
+	bitboard64 pinned = Pinned(color, board);
+	bitboard64 targets = (captures ? board->getOccupied((Piece::Color)!color) : 0) | (quiets ? ~board->getOccupied() : 0);
+	bool kingMoves = (sources & Bitboard::Square(king->pos)) != 0;
+	if (checkers) {
+		genEvasions(color, checkers, pinned, sources, targets, board, info, captures, quiets);
+	} else {
+		genLegalPieceMoves(color, sources, targets, ~(bitboard64)0, pinned, board, info, captures, quiets);
+		if (kingMoves) genLegalKingMoves(color, targets, board);
+		if (quiets && kingMoves) {
+			// Castling. canCastle checks the square the king passes through, so only its destination is left to check.
+			if (info->canCastle(color, GameInfo::KINGSIDE, board) && !AttackersOf(king->pos + 2, (Piece::Color)!color, board->getOccupied(), board)) {
+				const Piece *rook = board->getPiece(king->pos + 3);
+				insert(Move(king, king->pos, king->pos + 2, rook, rook->pos, rook->pos - 2, Move::NORMAL));
+			}
+			if (info->canCastle(color, GameInfo::QUEENSIDE, board) && !AttackersOf(king->pos - 2, (Piece::Color)!color, board->getOccupied(), board)) {
+				const Piece *rook = board->getPiece(king->pos - 4);
+				insert(Move(king, king->pos, king->pos - 2, rook, rook->pos, rook->pos + 3, Move::NORMAL));
+			}
+		}
+	}
+}
+
+void MoveList::generateMailbox(Piece::Color color, Board *board, GameInfo *info, bool onlyInteresting) {
+	for (position pos = 0; pos < BOARDSIZE; pos++) {
+		const Piece *piece = board->getPiece(pos);
+		if (piece && piece->color == color) generate(piece, board, info, onlyInteresting);
+	}
+	sort();
+}
+
+void MoveList::generate(const Piece *piece, Board *board, GameInfo *info, bool onlyInteresting) {
 	// Special moves
 	if (piece->type == Piece::PAWN) {
 		genPawnMoves(piece, board, info, onlyInteresting);
@@ -19,22 +143,22 @@ void MoveList::generate(Piece *piece, Board *board, GameInfo *info, bool onlyInt
 	} else if (!onlyInteresting && piece->type == Piece::KING) {
 		// Castling
 		if (info->canCastle(piece->color, GameInfo::KINGSIDE, board)) {
-			Piece *rook = board->getPiece(piece->pos + 3);
+			const Piece *rook = board->getPiece(piece->pos + 3);
 			if (!rook) std::cerr << "No kingside rook for color " << piece->color << std::endl;
 			insert(Move(piece, piece->pos, piece->pos + 2, rook, rook->pos, rook->pos - 2, Move::NORMAL));
 		}
 		if (info->canCastle(piece->color, GameInfo::QUEENSIDE, board)) {
-			Piece *rook = board->getPiece(piece->pos - 4);
+			const Piece *rook = board->getPiece(piece->pos - 4);
 			if (!rook) std::cerr << "No queenside rook for color " << piece->color << std::endl;
 			insert(Move(piece, piece->pos, piece->pos - 2, rook, rook->pos, rook->pos + 3, Move::NORMAL));
 		}
 	}
 	// For each offset that a piece can move in.
-	for (intlist::const_iterator offsetItr = Buffer::Offset[piece->type].begin();
-			offsetItr != Buffer::Offset[piece->type].end(); offsetItr++) {
-		for (position to = Buffer::Board[Buffer::Coords[piece->pos] + *offsetItr];
-				to >= 0; to = Buffer::Board[Buffer::Coords[to] + *offsetItr]) {
-			Piece *other = board->getPiece(to);
+	for (int i = 0; i < Buffer::NumOffsets[piece->type]; i++) {
+		int offset = Buffer::Offset[piece->type][i];
+		for (position to = Buffer::Board[Buffer::Coords[piece->pos] + offset];
+				to >= 0; to = Buffer::Board[Buffer::Coords[to] + offset]) {
+			const Piece *other = board->getPiece(to);
 			if (!other) {
 				// If this is an empty space, add it, and keep going.
 				if (!onlyInteresting) insert(Move(piece, piece->pos, to, 0, -1, -1, Move::NORMAL));
@@ -53,45 +177,83 @@ void MoveList::generate(Piece *piece, Board *board, GameInfo *info, bool onlyInt
 }
 
 bool MoveList::generateForHuman(position pos, Board *board, GameInfo *info) {
-	Piece *piece = board->getPiece(pos);
+	const Piece *piece = board->getPiece(pos);
 	if (!piece || piece->color != info->turn) return false;
-	generate(piece, board, info, false);
+	generateLegal(piece->color, board, info, Bitboard::Square(pos), true, true);
+	sort();
 	return true;
 }
 
 bool MoveList::UnderThreat(position pos, Piece::Color enemies, Board *board) {
-	// Under threat from pawns?
-	for (int i = -1; i <= 1; i += 2) {
-		position enemyPos = Buffer::Board[Buffer::Coords[pos] + Buffer::PawnOffset[!enemies] + i];
-		if (enemyPos < 0) continue;
-		Piece *enemyPawn = board->getPiece(enemyPos);
-		if (!enemyPawn) continue;
-		if (enemyPawn->color == enemies && enemyPawn->type == Piece::PAWN) return true;
-	}
-	// Under threat from anything else?
-	for (int type = 0; type < NUM_PIECE_TYPES; type++) {
-		// The queen can be tested using the rook and bishop moves.
-		if (type == Piece::QUEEN) continue;
-		bool queenCanCapture = (type != Piece::KNIGHT);
-		// For every piece type, see if the position can attack that piece type. If it can, it can be attacked by that piece type.
-		for (intlist::const_iterator offsetItr = Buffer::Offset[type].begin();
-			 offsetItr != Buffer::Offset[type].end(); offsetItr++) {
-			for (position to = Buffer::Board[Buffer::Coords[pos] + *offsetItr];
-				 to >= 0; to = Buffer::Board[Buffer::Coords[to] + *offsetItr]) {
-				Piece *other = board->getPiece(to);
-				if (other) {
-					if (other->color == enemies && (other->type == type || (other->type == Piece::QUEEN && queenCanCapture))) return true;
-					else break;
-				}
-				if (!Piece::CanSlide[type]) break;
-			}
-		}
-	}
-	return false;
+	return (board->getAttacks(enemies) & Bitboard::Square(pos)) != 0;
 }
 
 bool MoveList::InCheck(Piece::Color color, Board *board) {
-	return UnderThreat(board->getKing(color)->pos, (Piece::Color)!color, board);
+	return (board->getAttacks((Piece::Color)!color) & Bitboard::Square(board->getKing(color)->pos)) != 0;
+}
+
+bitboard64 MoveList::AttackersOf(position pos, Piece::Color attackers, bitboard64 occupied, const Board *board) {
+	bitboard64 queens = board->getPieces(attackers, Piece::QUEEN);
+	// A pawn of the other color on this square would attack the squares that pawns of the attacking color attack it from.
+	return (Bitboard::PawnAttacks[!attackers][pos] & board->getPieces(attackers, Piece::PAWN)) |
+		   (Bitboard::KnightAttacks[pos] & board->getPieces(attackers, Piece::KNIGHT)) |
+		   (Bitboard::KingAttacks[pos] & board->getPieces(attackers, Piece::KING)) |
+		   (Bitboard::BishopAttacks(pos, occupied) & (board->getPieces(attackers, Piece::BISHOP) | queens)) |
+		   (Bitboard::RookAttacks(pos, occupied) & (board->getPieces(attackers, Piece::ROOK) | queens));
+}
+
+bitboard64 MoveList::Pinned(Piece::Color color, const Board *board) {
+	Piece::Color enemy = (Piece::Color)!color;
+	position kingPos = board->getKing(color)->pos;
+	bitboard64 enemies = board->getOccupied(enemy);
+	bitboard64 queens = board->getPieces(enemy, Piece::QUEEN);
+	// Enemy sliders that would attack the king if none of our pieces were in the way.
+	bitboard64 snipers = (Bitboard::BishopAttacks(kingPos, enemies) & (board->getPieces(enemy, Piece::BISHOP) | queens)) |
+						 (Bitboard::RookAttacks(kingPos, enemies) & (board->getPieces(enemy, Piece::ROOK) | queens));
+	bitboard64 pinned = 0;
+	while (snipers) {
+		bitboard64 blockers = Bitboard::Between[kingPos][Bitboard::PopFirst(snipers)] & board->getOccupied();
+		// A piece is pinned if it is the only one in the way.
+		if (blockers && !(blockers & (blockers - 1))) pinned |= blockers & board->getOccupied(color);
+	}
+	return pinned;
+}
+
+int MoveList::StaticExchange(const Move &move, const Board *board) {
+	position to = move.subject_to;
+	// gain[i] is the material gained by the side making the ith capture if the exchange stopped there, from that side's point of view.
+	int gain[BOARDSIZE / 2];
+	gain[0] = move.isCapture() ? Piece::MaterialWorth[move.object.type] : 0;
+	// The worth of the piece standing on the square, which the next capture would win.
+	int targetWorth = Piece::MaterialWorth[move.subject.type];
+	if (move.type >= Move::PROMOTION) {
+		targetWorth = Piece::MaterialWorth[move.type - Move::PROMOTION];
+		gain[0] += targetWorth - Piece::MaterialWorth[Piece::PAWN];
+	}
+	// Pieces are taken off the occupancy as they capture, uncovering any slider behind them. An en passant victim isn't on the square.
+	bitboard64 occupied = board->getOccupied() & ~Bitboard::Square(move.subject_from);
+	if (move.isCapture()) occupied &= ~Bitboard::Square(move.object_from);
+	Piece::Color side = (Piece::Color)!move.subject.color;
+	int depth = 0;
+	while (depth < BOARDSIZE / 2 - 1) {
+		bitboard64 attackers = AttackersOf(to, side, occupied, board) & occupied;
+		if (!attackers) break;
+		int type = 0;
+		while (!(attackers & board->getPieces(side, ExchangeOrder[type]))) type++;
+		depth++;
+		gain[depth] = targetWorth - gain[depth - 1];
+		// If neither capturing nor stopping here is good for this side, it stops, and the rest of the exchange can't change the result.
+		if (std::max(-gain[depth - 1], gain[depth]) < 0) {
+			depth--;
+			break;
+		}
+		targetWorth = Piece::MaterialWorth[ExchangeOrder[type]];
+		occupied &= ~Bitboard::Square(__builtin_ctzll(attackers & board->getPieces(side, ExchangeOrder[type])));
+		side = (Piece::Color)!side;
+	}
+	// Each side either makes its capture or stops before it, whichever is better for it.
+	for (; depth > 0; depth--) gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+	return gain[0];
 }
 
 MoveList::const_iterator MoveList::getMove(position from, position to) const {
@@ -102,28 +264,167 @@ MoveList::const_iterator MoveList::getMove(position from, position to) const {
 	return itr;
 }
 
+MoveList::iterator MoveList::getMove(position from, position to, Move::Type type) {
+	iterator itr;
+	for (itr = begin(); itr != end(); itr++) {
+		if (itr->subject_from == from && itr->subject_to == to && itr->type == type) break;
+	}
+	return itr;
+}
+
+void MoveList::moveToFront(iterator moveItr) {
+	std::rotate(begin(), moveItr, moveItr + 1);
+}
+
 void MoveList::prune(Piece::Color enemies, Board *board) {
-	std::vector<iterator> movesToPrune;
-	for (iterator moveItr = begin(); moveItr != end(); moveItr++) {
-		board->executeMove(*moveItr);
+	// Legal moves are shuffled down over the pruned ones, keeping their order.
+	int legal = 0;
+	for (int i = 0; i < count; i++) {
+		board->executeMove(moves[i]);
 		// For each move, execute it on the board, and check for any danger to the king.
-		//if (UnderThreat(board->getKing((Piece::Color)!enemies)->pos, enemies, board))
-		if (InCheck((Piece::Color)!enemies, board))
-			movesToPrune.push_back(moveItr);
-		board->reverseMove(*moveItr);
+		bool inCheck = InCheck((Piece::Color)!enemies, board);
+		board->reverseMove(moves[i]);
+		if (!inCheck) moves[legal++] = moves[i];
 	}
-	for (std::vector<iterator>::iterator badMoveItr = movesToPrune.begin(); badMoveItr != movesToPrune.end(); badMoveItr++) {
-		erase(*badMoveItr);
+	count = legal;
+}
+
+void MoveList::addMoves(const Piece *piece, bitboard64 destinations, Board *board) {
+	while (destinations) {
+		position to = Bitboard::PopFirst(destinations);
+		const Piece *other = board->getPiece(to);
+		if (other) insert(Move(piece, piece->pos, to, other, to, -1, Move::NORMAL));
+		else insert(Move(piece, piece->pos, to, 0, -1, -1, Move::NORMAL));
+	}
+}
+
+void MoveList::genLegalPieceMoves(Piece::Color color, bitboard64 sources, bitboard64 targets, bitboard64 evasions, bitboard64 pinned, Board *board,
+								  GameInfo *info, bool captures, bool quiets) {
+	position kingPos = board->getKing(color)->pos;
+	bitboard64 occupied = board->getOccupied();
+	// Pawn moves are generated pseudo-legally, and then filtered in place.
+	int first = count;
+	genPawnMoves(color, sources, board, info, captures, quiets);
+	int legal = first;
+	for (int i = first; i < count; i++) {
+		const Move &move = moves[i];
+		// An en passant capture is the only move whose object isn't on its destination square.
+		if (move.object && move.object_from != move.subject_to) {
+			if (!LegalEnPassant(move, board)) continue;
+		} else {
+			if (!(evasions & Bitboard::Square(move.subject_to))) continue;
+			if ((pinned & Bitboard::Square(move.subject_from)) && !(Bitboard::Line[kingPos][move.subject_from] & Bitboard::Square(move.subject_to))) continue;
+		}
+		moves[legal++] = move;
+	}
+	count = legal;
+	// A pinned knight can never move.
+	for (bitboard64 knights = board->getPieces(color, Piece::KNIGHT) & sources & ~pinned; knights; ) {
+		position from = Bitboard::PopFirst(knights);
+		addMoves(board->getPiece(from), Bitboard::KnightAttacks[from] & targets, board);
+	}
+	for (bitboard64 bishops = board->getPieces(color, Piece::BISHOP) & sources; bishops; ) {
+		position from = Bitboard::PopFirst(bishops);
+		bitboard64 destinations = Bitboard::BishopAttacks(from, occupied) & targets;
+		if (pinned & Bitboard::Square(from)) destinations &= Bitboard::Line[kingPos][from];
+		addMoves(board->getPiece(from), destinations, board);
+	}
+	for (bitboard64 rooks = board->getPieces(color, Piece::ROOK) & sources; rooks; ) {
+		position from = Bitboard::PopFirst(rooks);
+		bitboard64 destinations = Bitboard::RookAttacks(from, occupied) & targets;
+		if (pinned & Bitboard::Square(from)) destinations &= Bitboard::Line[kingPos][from];
+		addMoves(board->getPiece(from), destinations, board);
+	}
+	for (bitboard64 queens = board->getPieces(color, Piece::QUEEN) & sources; queens; ) {
+		position from = Bitboard::PopFirst(queens);
+		bitboard64 destinations = (Bitboard::BishopAttacks(from, occupied) | Bitboard::RookAttacks(from, occupied)) & targets;
+		if (pinned & Bitboard::Square(from)) destinations &= Bitboard::Line[kingPos][from];
+		addMoves(board->getPiece(from), destinations, board);
+	}
+}
+
+void MoveList::genLegalKingMoves(Piece::Color color, bitboard64 targets, Board *board) {
+	const Piece *king = board->getKing(color);
+	// The king is taken off the board when testing its destinations, so that it doesn't block an attack along the line it is moving on.
+	bitboard64 occupied = board->getOccupied() & ~Bitboard::Square(king->pos);
+	for (bitboard64 destinations = Bitboard::KingAttacks[king->pos] & targets; destinations; ) {
+		position to = Bitboard::PopFirst(destinations);
+		if (AttackersOf(to, (Piece::Color)!color, occupied, board)) continue;
+		const Piece *other = board->getPiece(to);
+		if (other) insert(Move(king, king->pos, to, other, to, -1, Move::NORMAL));
+		else insert(Move(king, king->pos, to, 0, -1, -1, Move::NORMAL));
+	}
+}
+
+void MoveList::genEvasions(Piece::Color color, bitboard64 checkers, bitboard64 pinned, bitboard64 sources, bitboard64 targets, Board *board,
+						   GameInfo *info, bool captures, bool quiets) {
+	position kingPos = board->getKing(color)->pos;
+	// In double check, only moving the king can help.
+	if (!(checkers & (checkers - 1))) {
+		position checker = __builtin_ctzll(checkers);
+		// Block the check, or capture the checking piece.
+		bitboard64 evasions = checkers | Bitboard::Between[kingPos][checker];
+		genLegalPieceMoves(color, sources, evasions & targets, evasions, pinned, board, info, captures, quiets);
+	}
+	if (sources & Bitboard::Square(kingPos)) genLegalKingMoves(color, targets, board);
+}
+
+bool MoveList::LegalEnPassant(const Move &move, const Board *board) {
+	Piece::Color color = move.subject.color;
+	bitboard64 occupied = (board->getOccupied() ^ Bitboard::Square(move.subject_from) ^ Bitboard::Square(move.object_from)) | Bitboard::Square(move.subject_to);
+	// The captured pawn can't attack anything once it has been taken.
+	return !(AttackersOf(board->getKing(color)->pos, (Piece::Color)!color, occupied, board) & ~Bitboard::Square(move.object_from));
+}
+
+void MoveList::genPawnMoves(Piece::Color color, bitboard64 sources, Board *board, GameInfo *info, bool captures, bool quiets) {
+	bitboard64 empty = ~board->getOccupied();
+	bitboard64 enemies = board->getOccupied((Piece::Color)!color);
+	bitboard64 promotionRank = (bitboard64)0xFF << (NUM_FILES * Piece::PawnPromotionRank[color]);
+	// Pawns start on the rank that the other color's pawns promote from.
+	bitboard64 startRank = (bitboard64)0xFF << (NUM_FILES * Piece::PawnPromotionRank[!color]);
+	int up = Buffer::PawnOffset[color] / Buffer::N * NUM_FILES;
+	for (bitboard64 pawns = board->getPieces(color, Piece::PAWN) & sources; pawns; ) {
+		position from = Bitboard::PopFirst(pawns);
+		const Piece *pawn = board->getPiece(from);
+		bool promoting = (Bitboard::Square(from) & promotionRank) != 0;
+		// Advances are only interesting if they promote.
+		if (promoting ? captures : quiets) {
+			position advance = from + up;
+			if (empty & Bitboard::Square(advance)) {
+				genPawnPromotions(Move(pawn, from, advance, 0, -1, -1, Move::NORMAL));
+				// Double advance
+				if ((Bitboard::Square(from) & startRank) && (empty & Bitboard::Square(advance + up))) {
+					insert(Move(pawn, from, advance + up, 0, -1, -1, Move::PAWN_DOUBLE_ADVANCE));
+				}
+			}
+		}
+		// Capture
+		if (!captures) continue;
+		for (bitboard64 targets = Bitboard::PawnAttacks[color][from] & enemies; targets; ) {
+			position to = Bitboard::PopFirst(targets);
+			genPawnPromotions(Move(pawn, from, to, board->getPiece(to), to, -1, Move::NORMAL));
+		}
+	}
+	// En passant. The square behind the target must be empty, and any pawn that attacks it can capture.
+	const Piece *target = captures && info->enPassantTarget >= 0 ? board->getPiece(info->enPassantTarget) : 0;
+	if (target) {
+		position to = target->pos + up;
+		if (empty & Bitboard::Square(to)) {
+			for (bitboard64 capturers = Bitboard::PawnAttacks[!color][to] & board->getPieces(color, Piece::PAWN) & sources; capturers; ) {
+				position from = Bitboard::PopFirst(capturers);
+				insert(Move(board->getPiece(from), from, to, target, target->pos, -1, Move::NORMAL));
+			}
+		}
 	}
 }
 
-void MoveList::genPawnMoves(Piece *pawn, Board *board, GameInfo *info, bool onlyInteresting) {
+void MoveList::genPawnMoves(const Piece *pawn, Board *board, GameInfo *info, bool onlyInteresting) {
 	if (!onlyInteresting || Position::Rank(pawn->pos) == Piece::PawnPromotionRank[pawn->color]) {
 		position advance = Buffer::Board[Buffer::Coords[pawn->pos] + Buffer::PawnOffset[pawn->color]];
 		if (advance >= 0 && !board->getPiece(advance)) {
 			genPawnPromotions(Move(pawn, pawn->pos, advance, 0, -1, -1, Move::NORMAL));
 			// Double advance
-			if (Piece::InitialSetup[pawn->color][Piece::PAWN].count(pawn->pos) != 0) {
+			if (Piece::InitialSetup[pawn->color][Piece::PAWN] & Bitboard::Square(pawn->pos)) {
 				advance = Buffer::Board[Buffer::Coords[advance] + Buffer::PawnOffset[pawn->color]];
 				if (advance >= 0 && !board->getPiece(advance)) {
 					insert(Move(pawn, pawn->pos, advance, 0, -1, -1, Move::PAWN_DOUBLE_ADVANCE));
@@ -135,11 +436,11 @@ void MoveList::genPawnMoves(Piece *pawn, Board *board, GameInfo *info, bool only
 	for (int i = -1; i <= 1; i += 2) {
 		position capture = Buffer::Board[Buffer::Coords[pawn->pos] + Buffer::PawnOffset[pawn->color] + i];
 		if (capture < 0) continue;
-		Piece *other = board->getPiece(capture);
+		const Piece *other = board->getPiece(capture);
 		if (!other) {
 			// En passant
-			if (info->enPassantTarget && info->enPassantTarget->pos == pawn->pos + i)
-				insert(Move(pawn, pawn->pos, capture, info->enPassantTarget, info->enPassantTarget->pos, -1, Move::NORMAL));
+			if (info->enPassantTarget >= 0 && info->enPassantTarget == pawn->pos + i)
+				insert(Move(pawn, pawn->pos, capture, board->getPiece(info->enPassantTarget), info->enPassantTarget, -1, Move::NORMAL));
 		} else if (other->color != pawn->color) {
 			genPawnPromotions(Move(pawn, pawn->pos, capture, other, other->pos, -1, Move::NORMAL));
 		}
@@ -148,7 +449,7 @@ void MoveList::genPawnMoves(Piece *pawn, Board *board, GameInfo *info, bool only
 }
 
 void MoveList::genPawnPromotions(Move move) {
-	if (Position::Rank(move.subject_from) == Piece::PawnPromotionRank[move.subject->color]) {
+	if (Position::Rank(move.subject_from) == Piece::PawnPromotionRank[move.subject.color]) {
 		move.type = Move::PROMOTION_BISHOP;
 		insert(move);
 		move.type = Move::PROMOTION_KNIGHT;
@@ -1,36 +1,105 @@
 #pragma once
 
-#include <set>
+#include <algorithm>
 #include "board.hpp"
 #include "buffer.hpp"
 #include "move.hpp"
 #include "piece.hpp"
 
+// No legal chess position has more than 218 moves. This leaves room for pseudo-legal moves.
+#define MAX_MOVES 256
+
 namespace ChessProject {
 
 struct GameInfo;
 
-class MoveList : public std::multiset<Move, Move::Evaluator> {
+// A fixed-capacity list of moves. The moves are stored in an array inside the list itself, so that generating moves never allocates memory.
+//After generation, the moves are ordered with the best weak evaluation first, except by the staged generator used by the move picker.
+class MoveList {
 public:
+	typedef Move* iterator;
+	typedef const Move* const_iterator;
+	MoveList();
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+	bool empty() const;
+	int size() const;
+	void clear();
+	// Appends a move to the end of the list.
+	void insert(const Move &move);
+	// Removes the moves from first to the end of the list.
+	void erase(iterator first);
+	// Evaluates every move, then orders the list by weak evaluation, best first. Moves with the same evaluation keep the order they were
+	//generated in.
+	void sort();
 	// Generates all pseudo-legal moves the specified color can make. If onlyInteresting is true, only generates captures and promotions.
+	// Moves are generated from the board's bitboards with precalculated attack tables.
 	void generate(Piece::Color color, Board *board, GameInfo *info, bool onlyInteresting = false);
+	// Generates only the legal moves the specified color can make. If onlyInteresting is true, only generates captures and promotions, unless
+	//the color is in check, in which case every evasion is generated.
+	// The pieces giving check and the pinned pieces are found once, so that no move has to be made on the board to test its legality.
+	void generateLegal(Piece::Color color, Board *board, GameInfo *info, bool onlyInteresting = false);
+	// Appends the legal moves of the pieces on the squares in sources, without ordering them. Captures and promotions are generated if
+	//captures is true, and every other move if quiets is true, whether or not the color is in check. This lets the move picker generate
+	//one kind of move at a time, or check a single move by generating the moves of one piece.
+	void generateLegal(Piece::Color color, Board *board, GameInfo *info, bitboard64 sources, bool captures, bool quiets);
+	// Generates the same moves as generate(), but by walking the buffer board for every piece. This is much slower, and is kept so that the
+	//two generators can be checked against each other.
+	void generateMailbox(Piece::Color color, Board *board, GameInfo *info, bool onlyInteresting = false);
 	// Generate pseudo-legal moves for one piece.
-	void generate(Piece *piece, Board *board, GameInfo *info, bool onlyInteresting = false);
-	// Convenience method for human moves. If the position does not match a piece on the board of the color whose turn it is, returns false.
+	void generate(const Piece *piece, Board *board, GameInfo *info, bool onlyInteresting = false);
+	// Convenience method for human moves. Generates the legal moves of the piece at the given position.
+	// If the position does not match a piece on the board of the color whose turn it is, returns false.
 	bool generateForHuman(position pos, Board *board, GameInfo *info);
 	// Erases all moves that leave the king in check.
 	void prune(Piece::Color enemies, Board *board);
 	// If the move list contains this move, returns its iterator, otherwise returns end().
 	const_iterator getMove(position from, position to) const;
-	// Returns true if a given position is under threat from its enemy team.
+	// As above, but also matches the move type. This distinguishes between promotions to different piece types.
+	iterator getMove(position from, position to, Move::Type type);
+	// Moves the move at the given iterator to the front of the list, shifting the moves before it back by one.
+	void moveToFront(iterator moveItr);
+	// Returns true if a given position is under threat from its enemy team. Reads the enemy's attack map.
 	static bool UnderThreat(position pos, Piece::Color enemies, Board *board);
-	// Returns true if the specified color is in check.
+	// Returns true if the specified color is in check. Reads the enemy's attack map.
 	static bool InCheck(Piece::Color color, Board *board);
+	// Returns the pieces of the attacking color that attack a square, as if the board had the given occupancy.
+	static bitboard64 AttackersOf(position pos, Piece::Color attackers, bitboard64 occupied, const Board *board);
+	// Returns the pieces of the specified color that are pinned to their king.
+	static bitboard64 Pinned(Piece::Color color, const Board *board);
+	// Static exchange evaluation. Returns the material the moving side can expect to gain if both sides keep capturing on the destination
+	//square of the move, each with its least valuable attacker, and each stopping as soon as capturing again would lose material. Pieces
+	//behind an attacker join in once it has captured (x-rays). Pins and checks are ignored.
+	static int StaticExchange(const Move &move, const Board *board);
 private:
+	// Adds a move for every destination square in the bitboard.
+	void addMoves(const Piece *piece, bitboard64 destinations, Board *board);
+	// Generates the legal moves of every piece on the squares in sources but the king. Destinations are limited to targets, and pinned pieces
+	//can only move along the line through their king. Pawn moves must also land in evasions (every square, unless in check).
+	void genLegalPieceMoves(Piece::Color color, bitboard64 sources, bitboard64 targets, bitboard64 evasions, bitboard64 pinned, Board *board,
+							GameInfo *info, bool captures, bool quiets);
+	// Generates the king moves to squares in targets that are not attacked.
+	void genLegalKingMoves(Piece::Color color, bitboard64 targets, Board *board);
+	// Generates the moves that get a king out of check. In double check, only the king can move. Otherwise, the checking piece can also be
+	//captured or blocked.
+	void genEvasions(Piece::Color color, bitboard64 checkers, bitboard64 pinned, bitboard64 sources, bitboard64 targets, Board *board,
+					 GameInfo *info, bool captures, bool quiets);
+	// Returns true if an en passant capture does not leave the king in check. The captured pawn leaves the board along with the capturing
+	//pawn, which can uncover an attack along a rank that a pin test doesn't see.
+	static bool LegalEnPassant(const Move &move, const Board *board);
+	// Generates pseudo-legal moves for the pawns of the given color on the squares in sources using bitboards. Promotions count as captures,
+	//and every other advance as a quiet move.
+	void genPawnMoves(Piece::Color color, bitboard64 sources, Board *board, GameInfo *info, bool captures, bool quiets);
 	// Generates psuedo-legal moves for a pawn.
-	void genPawnMoves(Piece *pawn, Board *board, GameInfo *info, bool onlyInteresting = false);
+	void genPawnMoves(const Piece *pawn, Board *board, GameInfo *info, bool onlyInteresting = false);
 	// Generates pawn promotion moves for each of the piece types a pawn can promote to for a given move.
 	void genPawnPromotions(Move move);
+	// Piece types from least to most valuable, which is the order the static exchange evaluation uses them to capture in.
+	static const Piece::Type ExchangeOrder[NUM_PIECE_TYPES];
+	Move moves[MAX_MOVES];
+	int count;
 };
 
 }
@@ -0,0 +1,210 @@
+#include "movepicker.hpp"
+
+namespace ChessProject {
+
+thread_local Move MovePicker::Killers[MAX_PLY][NUM_KILLERS];
+thread_local Move MovePicker::CounterMoves[NUM_COLORS][NUM_PIECE_TYPES][BOARDSIZE];
+
+MovePicker::MovePicker(Board *board, GameInfo *gameInfo, MoveList &moveList, const Move &hashMove, int ply, const Move &previousMove) :
+	board(board),
+	gameInfo(gameInfo),
+	moveList(moveList),
+	ply(ply),
+	quiescence(false),
+	currentStage(HASH_MOVE),
+	pickedStage(HASH_MOVE),
+	hashMove(hashMove),
+	killerIndex(0),
+	numPicked(0) {
+	for (int i = 0; i < NUM_KILLERS; i++) killers[i] = Killers[ply][i];
+	if (previousMove.subject) counterMove = CounterMoves[previousMove.subject.color][previousMove.subject.type][previousMove.subject_to];
+	moveList.clear();
+	current = last = badCaptures = capturesEnd = moveList.begin();
+}
+
+MovePicker::MovePicker(Board *board, GameInfo *gameInfo, MoveList &moveList, const Move &hashMove) :
+	MovePicker(board, gameInfo, moveList, hashMove, 0, Move()) {
+	quiescence = true;
+}
+
+bool MovePicker::next(Move &move) {
+	while (true) {
+		switch (currentStage) {
+			case HASH_MOVE:
+				currentStage = gameInfo->inCheck ? GENERATE_EVASIONS : GENERATE_CAPTURES;
+				if (findLegal(hashMove, true, !quiescence || gameInfo->inCheck, move)) {
+					picked[numPicked++] = move;
+					pickedStage = HASH_MOVE;
+					return true;
+				}
+				break;
+			case GENERATE_CAPTURES:
+				moveList.generateLegal(gameInfo->turn, board, gameInfo, ~(bitboard64)0, true, false);
+				// The good captures are moved to the front, leaving the bad ones behind them. Good captures are ordered by MVV-LVA, and bad ones
+				//by how much they lose.
+				current = last = moveList.begin();
+				capturesEnd = moveList.end();
+				for (MoveList::iterator moveItr = moveList.begin(); moveItr != capturesEnd; moveItr++) {
+					int exchange = MoveList::StaticExchange(*moveItr, board);
+					if (exchange >= 0 && (moveItr->type < Move::PROMOTION || moveItr->type == Move::PROMOTION_QUEEN)) {
+						// Victims are worth at least 100, so the victim always outweighs the attacker, even a king (worth 10000). A promotion
+						//without a capture has no victim.
+						int victim = moveItr->isCapture() ? Piece::MaterialWorth[moveItr->object.type] : 0;
+						moveItr->weakEval = victim * 100 - Piece::MaterialWorth[moveItr->subject.type];
+						if (moveItr->type >= Move::PROMOTION) moveItr->weakEval += Piece::MaterialWorth[moveItr->type - Move::PROMOTION] * 100;
+						std::swap(*moveItr, *last++);
+					} else {
+						moveItr->weakEval = exchange;
+					}
+				}
+				badCaptures = last;
+				currentStage = GOOD_CAPTURES;
+				break;
+			case GOOD_CAPTURES:
+				while (current != last) {
+					MoveList::iterator moveItr = pickBest();
+					if (isPicked(*moveItr)) continue;
+					move = *moveItr;
+					pickedStage = GOOD_CAPTURES;
+					return true;
+				}
+				if (quiescence) {
+					current = badCaptures;
+					last = capturesEnd;
+					currentStage = BAD_CAPTURES;
+				} else {
+					currentStage = KILLERS;
+				}
+				break;
+			case KILLERS:
+				while (killerIndex < NUM_KILLERS) {
+					const Move &killer = killers[killerIndex++];
+					if (isPicked(killer) || !findLegal(killer, false, true, move)) continue;
+					picked[numPicked++] = move;
+					pickedStage = KILLERS;
+					return true;
+				}
+				currentStage = COUNTERMOVE;
+				break;
+			case COUNTERMOVE:
+				currentStage = GENERATE_QUIETS;
+				if (!isPicked(counterMove) && findLegal(counterMove, false, true, move)) {
+					picked[numPicked++] = move;
+					pickedStage = COUNTERMOVE;
+					return true;
+				}
+				break;
+			case GENERATE_QUIETS:
+				// The quiet moves go after the captures, which still hold the losing ones.
+				current = moveList.end();
+				moveList.generateLegal(gameInfo->turn, board, gameInfo, ~(bitboard64)0, false, true);
+				last = moveList.end();
+				for (MoveList::iterator moveItr = current; moveItr != last; moveItr++) {
+					moveItr->weakEval = Move::HistoryHeuristic[moveItr->subject_from][moveItr->subject_to];
+				}
+				currentStage = QUIETS;
+				break;
+			case QUIETS:
+				while (current != last) {
+					MoveList::iterator moveItr = pickBest();
+					if (isPicked(*moveItr)) continue;
+					move = *moveItr;
+					pickedStage = QUIETS;
+					return true;
+				}
+				current = badCaptures;
+				last = capturesEnd;
+				currentStage = BAD_CAPTURES;
+				break;
+			case BAD_CAPTURES:
+				while (current != last) {
+					MoveList::iterator moveItr = pickBest();
+					if (isPicked(*moveItr)) continue;
+					move = *moveItr;
+					pickedStage = BAD_CAPTURES;
+					return true;
+				}
+				currentStage = DONE;
+				break;
+			case GENERATE_EVASIONS:
+				moveList.generateLegal(gameInfo->turn, board, gameInfo, ~(bitboard64)0, true, true);
+				for (MoveList::iterator moveItr = moveList.begin(); moveItr != moveList.end(); moveItr++) moveItr->evaluate();
+				current = moveList.begin();
+				last = moveList.end();
+				currentStage = EVASIONS;
+				break;
+			case EVASIONS:
+				while (current != last) {
+					MoveList::iterator moveItr = pickBest();
+					if (isPicked(*moveItr)) continue;
+					move = *moveItr;
+					pickedStage = EVASIONS;
+					return true;
+				}
+				currentStage = DONE;
+				break;
+			case DONE:
+				return false;
+		}
+	}
+}
+
+MovePicker::Stage MovePicker::stage() const {
+	return pickedStage;
+}
+
+void MovePicker::StoreCutoff(const Move &move, int ply, const Move &previousMove) {
+	// The newest killer goes first, and the older one is forgotten.
+	if (!SameMove(move, Killers[ply][0])) {
+		for (int i = NUM_KILLERS - 1; i > 0; i--) Killers[ply][i] = Killers[ply][i - 1];
+		Killers[ply][0] = move;
+	}
+	if (previousMove.subject) CounterMoves[previousMove.subject.color][previousMove.subject.type][previousMove.subject_to] = move;
+}
+
+void MovePicker::ClearKillers() {
+	for (int ply = 0; ply < MAX_PLY; ply++) {
+		for (int i = 0; i < NUM_KILLERS; i++) Killers[ply][i] = Move();
+	}
+}
+
+bool MovePicker::SameMove(const Move &move1, const Move &move2) {
+	return move1.subject_from == move2.subject_from && move1.subject_to == move2.subject_to && move1.type == move2.type;
+}
+
+bool MovePicker::findLegal(const Move &candidate, bool captures, bool quiets, Move &move) {
+	if (candidate.subject_from < 0) return false;
+	const Piece *piece = board->getPiece(candidate.subject_from);
+	if (!piece || piece->color != gameInfo->turn) return false;
+	// The piece's moves are generated after any moves already in the list, and removed again once the candidate has been looked for.
+	MoveList::iterator first = moveList.end();
+	moveList.generateLegal(gameInfo->turn, board, gameInfo, Bitboard::Square(candidate.subject_from), captures, quiets);
+	bool found = false;
+	for (MoveList::iterator moveItr = first; moveItr != moveList.end(); moveItr++) {
+		if (SameMove(*moveItr, candidate)) {
+			move = *moveItr;
+			found = true;
+			break;
+		}
+	}
+	moveList.erase(first);
+	return found;
+}
+
+bool MovePicker::isPicked(const Move &move) const {
+	for (int i = 0; i < numPicked; i++) {
+		if (SameMove(picked[i], move)) return true;
+	}
+	return false;
+}
+
+MoveList::iterator MovePicker::pickBest() {
+	MoveList::iterator best = current;
+	for (MoveList::iterator moveItr = current + 1; moveItr != last; moveItr++) {
+		if (moveItr->weakEval > best->weakEval) best = moveItr;
+	}
+	std::swap(*best, *current);
+	return current++;
+}
+
+}
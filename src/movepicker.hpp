@@ -0,0 +1,95 @@
+#pragma once
+
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "gameinfo.hpp"
+#include "move.hpp"
+#include "movelist.hpp"
+#include "piece.hpp"
+
+// The furthest from the root that any node can be, including quiescence nodes.
+#define MAX_PLY 128
+// The number of killer moves remembered for each ply.
+#define NUM_KILLERS 2
+
+namespace ChessProject {
+
+// Hands out the legal moves of a search node one at a time, in the order they should be searched. Moves are generated and ordered in stages,
+//so that if an early move causes a cutoff, the work for the later stages is never done. The stages are:
+// 1 - The hash move. This is the best move from the transposition table, or the move passed in at the root.
+// 2 - Captures and queen promotions that don't lose material by static exchange evaluation, ordered by most valuable victim, then least
+//valuable attacker (MVV-LVA).
+// 3 - The killer moves of the ply. These are quiet moves that caused a cutoff in another node at the same distance from the root.
+// 4 - The countermove. This is the quiet move that last caused a cutoff straight after the opponent's previous move.
+// 5 - The remaining quiet moves, ordered by the history heuristic.
+// 6 - Losing captures and underpromotions, least losing first.
+// When in check, every evasion is generated and ordered at once after the hash move, as there are usually only a few.
+// For quiescence search, stages 3 to 5 are skipped, and the hash move is only used if it is a capture or promotion.
+class MovePicker {
+public:
+	enum Stage {
+		HASH_MOVE,
+		GENERATE_CAPTURES,
+		GOOD_CAPTURES,
+		KILLERS,
+		COUNTERMOVE,
+		GENERATE_QUIETS,
+		QUIETS,
+		BAD_CAPTURES,
+		GENERATE_EVASIONS,
+		EVASIONS,
+		DONE
+	};
+	// Moves are generated into moveList, which must not be used for anything else until the picker is done with. Only the source,
+	//destination and type of hashMove are used, and it doesn't have to be legal. previousMove is the move that led to this node, and has
+	//no subject at the root or after a null move.
+	MovePicker(Board *board, GameInfo *gameInfo, MoveList &moveList, const Move &hashMove, int ply, const Move &previousMove);
+	// Picks moves for quiescence search.
+	MovePicker(Board *board, GameInfo *gameInfo, MoveList &moveList, const Move &hashMove);
+	// Stores the next move in move. Returns false once every legal move has been picked.
+	bool next(Move &move);
+	// Returns the stage that the last move picked came from.
+	Stage stage() const;
+	// Records a quiet move that caused a beta cutoff as a killer move for its ply, and as the countermove to the move before it.
+	static void StoreCutoff(const Move &move, int ply, const Move &previousMove);
+	// Forgets the killer moves of the calling thread. Killers are only relevant to the position they were found in, so this is done before
+	//each search. Countermoves and history are kept.
+	static void ClearKillers();
+private:
+	// Every search thread has its own killers and countermoves. Countermoves are indexed by the color, type and destination of the
+	//piece that made the previous move.
+	static thread_local Move Killers[MAX_PLY][NUM_KILLERS];
+	static thread_local Move CounterMoves[NUM_COLORS][NUM_PIECE_TYPES][BOARDSIZE];
+	// Returns true if both moves have the same source, destination and type.
+	static bool SameMove(const Move &move1, const Move &move2);
+	Board *board;
+	GameInfo *gameInfo;
+	MoveList &moveList;
+	int ply;
+	bool quiescence;
+	Stage currentStage;
+	// The stage of the last move returned by next().
+	Stage pickedStage;
+	// The candidates for the hash move, killer and countermove stages.
+	Move hashMove;
+	Move killers[NUM_KILLERS];
+	Move counterMove;
+	int killerIndex;
+	// The moves that have already been picked by the hash move, killer and countermove stages, so that they aren't picked again later.
+	Move picked[NUM_KILLERS + 2];
+	int numPicked;
+	// The moves of the current stage that are still to be picked run from current to last.
+	MoveList::iterator current, last;
+	// Losing captures are left in the list after the good ones, and picked once the quiet moves are done.
+	MoveList::iterator badCaptures, capturesEnd;
+	// Looks for a candidate move amongst the legal moves of the piece on its source square. If it is there, the legal move is stored in move
+	//and true is returned. Only captures and promotions are considered if captures is true, and only other moves if quiets is true.
+	bool findLegal(const Move &candidate, bool captures, bool quiets, Move &move);
+	// Returns true if the move has already been picked by the hash move, killer or countermove stages.
+	bool isPicked(const Move &move) const;
+	// Swaps the move with the best weak evaluation from current to last into current, and returns it. Picking one at a time means that no
+	//time is spent ordering moves after a cutoff.
+	MoveList::iterator pickBest();
+};
+
+}
@@ -0,0 +1,47 @@
+#include "pawntable.hpp"
+
+namespace ChessProject {
+
+PawnTable::PawnTable(std::size_t sizeKB) {
+	std::size_t maxEntries = (sizeKB * 1024) / sizeof(Entry);
+	std::size_t numEntries = 1;
+	while (numEntries * 2 <= maxEntries) numEntries *= 2;
+	entries.resize(numEntries);
+	mask = numEntries - 1;
+	clear();
+}
+
+void PawnTable::clear() {
+	// An entry with pawns on the first rank can never match a real position.
+	for (std::vector<Entry>::iterator entryItr = entries.begin(); entryItr != entries.end(); entryItr++) {
+		entryItr->pawns[Piece::WHITE] = entryItr->pawns[Piece::BLACK] = ~(bitboard64)0;
+	}
+	probes = 0;
+	hits = 0;
+}
+
+bool PawnTable::probe(bitboard64 whitePawns, bitboard64 blackPawns, bool endGame, Entry &entry) {
+	probes++;
+	const Entry &stored = entries[Key(whitePawns, blackPawns, endGame) & mask];
+	if (stored.pawns[Piece::WHITE] != whitePawns || stored.pawns[Piece::BLACK] != blackPawns || stored.endGame != endGame) return false;
+	hits++;
+	entry = stored;
+	return true;
+}
+
+void PawnTable::store(const Entry &entry) {
+	entries[Key(entry.pawns[Piece::WHITE], entry.pawns[Piece::BLACK], entry.endGame) & mask] = entry;
+}
+
+uint64_t PawnTable::Key(bitboard64 whitePawns, bitboard64 blackPawns, bool endGame) {
+	// Multiply each bitboard by a different odd constant, and finish with the MurmurHash3 64-bit mixer.
+	uint64_t key = whitePawns * 0x9E3779B97F4A7C15ULL ^ blackPawns * 0xC2B2AE3D27D4EB4FULL ^ (uint64_t)endGame;
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDULL;
+	key ^= key >> 33;
+	key *= 0xC4CEB9FE1A85EC53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+}
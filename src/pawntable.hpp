@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "bitboard.hpp"
+#include "piece.hpp"
+
+namespace ChessProject {
+
+// The pawn table caches pawn structure evaluations. Pawns move far less often than other pieces, so most positions in a search tree share
+//their pawn structure with many others, and the result of evaluating it can nearly always be reused.
+// Entries are keyed on the pawns of both colors and the endgame flag (which changes the passed pawn bonus). The full pawn bitboards are
+//stored in each entry, so a hit is always exact.
+// A pawn table is not thread safe. Each search thread should use its own.
+class PawnTable {
+public:
+	// The default size of the table in kilobytes.
+	static const std::size_t DefaultSizeKB = 1024;
+	struct Entry {
+		bitboard64 pawns[NUM_COLORS];
+		bool endGame;
+		// The pawn structure evaluation relative to white.
+		int score;
+		// The pawns of each color that are passed.
+		bitboard64 passed[NUM_COLORS];
+	};
+	PawnTable(std::size_t sizeKB = DefaultSizeKB);
+	// Empties every entry in the table.
+	void clear();
+	// Copies the entry stored for this pawn structure into entry. Returns false if there is none.
+	bool probe(bitboard64 whitePawns, bitboard64 blackPawns, bool endGame, Entry &entry);
+	// Stores an evaluated pawn structure, replacing whatever was in its slot.
+	void store(const Entry &entry);
+	// The number of probes and hits since the table was last cleared.
+	unsigned long probes, hits;
+private:
+	std::vector<Entry> entries;
+	// The number of entries minus one. Used to map a key onto an index.
+	std::size_t mask;
+	// Mixes the pawn bitboards and endgame flag into a well distributed 64-bit key.
+	static uint64_t Key(bitboard64 whitePawns, bitboard64 blackPawns, bool endGame);
+};
+
+}
@@ -1,4 +1,5 @@
 #include "piece.hpp"
+#include "evalparams.hpp"
 
 namespace ChessProject {
 
@@ -30,76 +31,24 @@ const bool Piece::CanSlide[NUM_PIECE_TYPES] = {
 	true // Rook
 };
 
-const int Piece::MaterialWorth[NUM_PIECE_TYPES] = {
-	300, // Bishop
-	10000, // King - arbitrarily large
-	300, // Knight
-	100, // Pawn
-	900, // Queen
-	500 // Rook
-};
-const int Piece::BonusTable[NUM_PIECE_TYPES][BOARDSIZE] = {
-	// In order to encourage piece development near the beginning of the game, almost every piece table penalizes pieces in their starting positions.
-	{ // Bishop - Centre squares are better due to increased mobility.
-		 -5,  -5, -10,  -5,  -5, -10,  -5,  -5,
-		 -5,   0,   0,   0,   0,   0,   0,  -5,
-		 -5,   0,   5,   5,   5,   5,   0,  -5,
-		 -5,   0,   5,  10,  10,   5,   0,  -5,
-		 -5,   0,   5,  10,  10,   5,   0,  -5,
-		 -5,   0,   5,   5,   5,   5,   0,  -5,
-		 -5,   0,   0,   0,   0,   0,   0,  -5,
-		 -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5
-	},
-	{ // King - Castling is encouraged. Staying at the home front is greatly encouraged.
-		  5,   5,  10,   0,  -5,   0,  10,   5,
-		-10, -10, -10, -10, -10, -10, -10, -10,
-		-20, -20, -20, -20, -20, -20, -20, -20,
-		-20, -20, -20, -20, -20, -20, -20, -20,
-		-20, -20, -20, -20, -20, -20, -20, -20,
-		-20, -20, -20, -20, -20, -20, -20, -20,
-		-20, -20, -20, -20, -20, -20, -20, -20,
-		-20, -20, -20, -20, -20, -20, -20, -20
-	},
-	{ // Knight - Knights are encouraged to leave their starting positions very early. Otherwise, control of the center and mobility are most important.
-		 -5, -10,  -5,  -5,  -5,  -5, -10,  -5,
-		 -5,   0,   0,   0,   0,   0,   0,  -5,
-		 -5,   0,   5,   5,   5,   5,   0,  -5,
-		 -5,   0,   5,  10,  10,   5,   0,  -5,
-		 -5,   0,   5,  10,  10,   5,   0,  -5,
-		 -5,   0,   5,   5,   5,   5,   0,  -5,
-		 -5,   0,   0,   0,   0,   0,   0,  -5,
-		 -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5
-	},
-	{ // Pawn - Pawns are encouraged to promote, and allow the bishop/queen to leave their starting positions.
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,  -5,  -5,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		 40,  40,  40,  40,  40,  40,  40,  40,
-		  0,   0,   0,   0,   0,   0,   0,   0
-	},
-	{ // Queen
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0
-	},
-	{ // Rook - Rooks are encouraged to occupy the seventh rank. Otherwise, any position is good.
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		  0,   0,   0,   0,   0,   0,   0,   0,
-		 20,  20,  20,  20,  20,  20,  20,  20,
-		  0,   0,   0,   0,   0,   0,   0,   0
-	}
+const int *const Piece::MaterialWorth = EvalParams::Weights + EvalParams::MATERIAL_WORTH;
+const int &Piece::DoubledPawnPenalty = EvalParams::Weights[EvalParams::DOUBLED_PAWN_PENALTY];
+const int &Piece::IsolatedPawnPenalty = EvalParams::Weights[EvalParams::ISOLATED_PAWN_PENALTY];
+const int &Piece::PassedPawnBonus = EvalParams::Weights[EvalParams::PASSED_PAWN_BONUS];
+const int &Piece::EndGamePassedPawnBonus = EvalParams::Weights[EvalParams::ENDGAME_PASSED_PAWN_BONUS];
+const int &Piece::BackwardPawnPenalty = EvalParams::Weights[EvalParams::BACKWARD_PAWN_PENALTY];
+const int &Piece::BothBishopsBonus = EvalParams::Weights[EvalParams::BOTH_BISHOPS_BONUS];
+const int &Piece::RookOnOpenFile = EvalParams::Weights[EvalParams::ROOK_ON_OPEN_FILE];
+
+const int Piece::MaxPhase;
+
+const int Piece::PhaseWeight[NUM_PIECE_TYPES] = {
+	1, // Bishop
+	0, // King
+	1, // Knight
+	0, // Pawn
+	4, // Queen
+	2 // Rook
 };
 
 const int Piece::FlippedBoard[BOARDSIZE] = {
@@ -113,28 +62,29 @@ const int Piece::FlippedBoard[BOARDSIZE] = {
 	 0,  1,  2,  3,  4,  5,  6,  7
 };
 
-const int Piece::GetPositionBonus(Color color, Type type, position pos) {
-	if (color == Piece::WHITE) return BonusTable[type][pos];
+const int Piece::GetPositionBonus(Color color, Type type, position pos, GamePhase phase) {
 	// Flip the position for the black player.
-	return BonusTable[type][FlippedBoard[pos]];
+	if (color == Piece::BLACK) pos = FlippedBoard[pos];
+	if (phase == ENDGAME && type == KING) return EvalParams::Weights[EvalParams::ENDGAME_KING_TABLE + pos];
+	return EvalParams::Weights[EvalParams::BONUS_TABLE + type * BOARDSIZE + pos];
 }
 
-const positionlist Piece::InitialSetup[NUM_COLORS][NUM_PIECE_TYPES] = {
+constexpr uint64_t Piece::InitialSetup[NUM_COLORS][NUM_PIECE_TYPES] = {
 	{ // White
-		boost::assign::list_of(2)(5), // Bishop
-		boost::assign::list_of(4), // King
-		boost::assign::list_of(1)(6), // Knight
-		boost::assign::list_of(8)(9)(10)(11)(12)(13)(14)(15), // Pawn
-		boost::assign::list_of(3), // Queen
-		boost::assign::list_of(0)(7) // Rook
+		0x0000000000000024ULL, // Bishop
+		0x0000000000000010ULL, // King
+		0x0000000000000042ULL, // Knight
+		0x000000000000ff00ULL, // Pawn
+		0x0000000000000008ULL, // Queen
+		0x0000000000000081ULL // Rook
 	},
 	{ // Black
-		boost::assign::list_of(58)(61), // Bishop
-		boost::assign::list_of(60), // King
-		boost::assign::list_of(57)(62), // Knight
-		boost::assign::list_of(48)(49)(50)(51)(52)(53)(54)(55), // Pawn
-		boost::assign::list_of(59), // Queen
-		boost::assign::list_of(56)(63) // Rook
+		0x2400000000000000ULL, // Bishop
+		0x1000000000000000ULL, // King
+		0x4200000000000000ULL, // Knight
+		0x00ff000000000000ULL, // Pawn
+		0x0800000000000000ULL, // Queen
+		0x8100000000000000ULL // Rook
 	}
 };
 
@@ -143,9 +93,18 @@ const int Piece::PawnPromotionRank[NUM_COLORS] = {
 	1 // Black
 };
 
+Piece::Piece() :
+	color(WHITE),
+	type(NONE),
+	pos(-1) { }
+
 Piece::Piece(Color color, Type type, position pos) :
 	color(color),
 	type(type),
 	pos(pos) { }
 
+Piece::operator bool() const {
+	return type != NONE;
+}
+
 }
@@ -1,21 +1,23 @@
 #pragma once
 
-#include <set>
-#include <boost/assign.hpp>
+#include <stdint.h>
 #include "position.hpp"
 
 #define NUM_COLORS 2
 #define NUM_PIECE_TYPES 6
+#define NUM_GAME_PHASES 2
 
 namespace ChessProject {
 
+// Pieces are small values, identified by the square they are on. They are copied into moves and board arrays rather than being allocated and
+//pointed to.
 class Piece {
 public:
-	enum Color {
+	enum Color : signed char {
 		WHITE = 0,
 		BLACK = 1
 	};
-	enum Type {
+	enum Type : signed char {
 		BISHOP = 0,
 		KING = 1,
 		KNIGHT = 2,
@@ -24,40 +26,49 @@ public:
 		ROOK = 5,
 		NONE = -1
 	};
+	// Piece square tables can differ between the middlegame and the endgame.
+	enum GamePhase {
+		MIDDLEGAME = 0,
+		ENDGAME = 1
+	};
 	// Array of ascii characters that represent each type of piece.
 	static const char Ascii[NUM_COLORS][NUM_PIECE_TYPES];
 	static const std::string ColorString[NUM_COLORS];
 	static const std::string TypeString[NUM_PIECE_TYPES];
 	// This array represents whether or not a piece can slide.
 	static const bool CanSlide[NUM_PIECE_TYPES];
-	// The weighting applied to every bit of material on the board for evaluation.
-	static const int MaterialWorth[NUM_PIECE_TYPES];
-	static const int GetPositionBonus(Color color, Type type, position pos);
+	// The weighting applied to every bit of material on the board for evaluation. The evaluation weights all live in EvalParams::Weights.
+	static const int *const MaterialWorth;
+	static const int GetPositionBonus(Color color, Type type, position pos, GamePhase phase = MIDDLEGAME);
+	// How much each piece contributes to the game phase. The phase starts at MaxPhase with every piece on the board, and falls towards 0
+	//as the non-pawn material is traded off.
+	static const int PhaseWeight[NUM_PIECE_TYPES];
+	static const int MaxPhase = 24;
 	// Pawn structure evaluation weightings.
-	static const int DoubledPawnPenalty = -10;
-	static const int IsolatedPawnPenalty = -20;
-	static const int PassedPawnBonus = 20;
-	static const int EndGamePassedPawnBonus = 100;
-	static const int BackwardPawnPenalty = -10;
-	static const int BothBishopsBonus = 20;
+	static const int &DoubledPawnPenalty;
+	static const int &IsolatedPawnPenalty;
+	static const int &PassedPawnBonus;
+	static const int &EndGamePassedPawnBonus;
+	static const int &BackwardPawnPenalty;
+	static const int &BothBishopsBonus;
 	// Rook evaluation weightings.
-	static const int RookOnOpenFile = 10;
+	static const int &RookOnOpenFile;
 	static const int RookOnSeventhRank = 10;
-	// The board's initial set up.
-	static const positionlist InitialSetup[NUM_COLORS][NUM_PIECE_TYPES];
+	// The board's initial set up, as the bitboard of squares that each color and type of piece starts on.
+	static const uint64_t InitialSetup[NUM_COLORS][NUM_PIECE_TYPES];
 	// The rank a pawn needs to advance from in order to promote.
 	static const int PawnPromotionRank[NUM_COLORS];
 	Color color;
 	Type type;
 	position pos;
+	// The null piece has a type of NONE. Empty squares hold null pieces.
+	Piece();
 	Piece(Color color, Type type, position pos);
+	// Returns true unless this is the null piece.
+	explicit operator bool() const;
 private:
-	// The values in the piece table for each piece is added to its material worth in the evaluation function.
-	static const int BonusTable[NUM_PIECE_TYPES][BOARDSIZE];
 	// The flipped board provides the coordinates required for the black player to look up their square table value.
 	static const int FlippedBoard[BOARDSIZE];
 };
 
-typedef std::set<Piece*> PieceList;
-
 }
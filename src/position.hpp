@@ -1,6 +1,5 @@
 #pragma once
 
-#include <set>
 #include <string>
 
 #define BOARDSIZE 64
@@ -10,7 +9,6 @@
 namespace ChessProject {
 
 typedef int position;
-typedef std::set<int> positionlist;
 
 // Positions are represented by an integer between 0 and 63.
 struct Position {
@@ -0,0 +1,85 @@
+#include "searchstats.hpp"
+
+namespace ChessProject {
+
+SearchStats::SearchStats() {
+	clear();
+}
+
+void SearchStats::clear() {
+	nodes = 0;
+	quiescenceNodes = 0;
+	betaCutoffs = 0;
+	firstMoveCutoffs = 0;
+	pvsResearches = 0;
+	aspirationResearches = 0;
+	seePrunes = 0;
+	deltaPrunes = 0;
+	nullMoveCutoffs = 0;
+	reductions = 0;
+	lmrResearches = 0;
+	bitbaseHits = 0;
+	maxQuiescenceDepth = 0;
+	time = 0;
+	iterationNodes.clear();
+}
+
+void SearchStats::add(const SearchStats &other) {
+	nodes += other.nodes;
+	quiescenceNodes += other.quiescenceNodes;
+	betaCutoffs += other.betaCutoffs;
+	firstMoveCutoffs += other.firstMoveCutoffs;
+	pvsResearches += other.pvsResearches;
+	aspirationResearches += other.aspirationResearches;
+	seePrunes += other.seePrunes;
+	deltaPrunes += other.deltaPrunes;
+	nullMoveCutoffs += other.nullMoveCutoffs;
+	reductions += other.reductions;
+	lmrResearches += other.lmrResearches;
+	bitbaseHits += other.bitbaseHits;
+	if (other.maxQuiescenceDepth > maxQuiescenceDepth) maxQuiescenceDepth = other.maxQuiescenceDepth;
+}
+
+double SearchStats::firstMoveCutoffRate() const {
+	if (betaCutoffs == 0) return 0;
+	return 100.0 * firstMoveCutoffs / betaCutoffs;
+}
+
+double SearchStats::branchingFactor(int depth) const {
+	if (depth < 2 || depth >= (int)iterationNodes.size() || iterationNodes[depth - 1] == 0) return 0;
+	return (double)iterationNodes[depth] / iterationNodes[depth - 1];
+}
+
+unsigned long SearchStats::nodesPerSecond() const {
+	// Avoid dividing by zero for searches that took less than a millisecond.
+	return (nodes + quiescenceNodes) * 1000 / (time > 0 ? time : 1);
+}
+
+std::string SearchStats::toJson() const {
+	std::ostringstream json;
+	json << std::fixed << std::setprecision(2);
+	json << "{\"nodes\": " << nodes
+		 << ", \"quiescenceNodes\": " << quiescenceNodes
+		 << ", \"betaCutoffs\": " << betaCutoffs
+		 << ", \"firstMoveCutoffRate\": " << firstMoveCutoffRate()
+		 << ", \"pvsResearches\": " << pvsResearches
+		 << ", \"aspirationResearches\": " << aspirationResearches
+		 << ", \"seePrunes\": " << seePrunes
+		 << ", \"deltaPrunes\": " << deltaPrunes
+		 << ", \"nullMoveCutoffs\": " << nullMoveCutoffs
+		 << ", \"reductions\": " << reductions
+		 << ", \"lmrResearches\": " << lmrResearches
+		 << ", \"bitbaseHits\": " << bitbaseHits
+		 << ", \"maxQuiescenceDepth\": " << maxQuiescenceDepth
+		 << ", \"time\": " << time
+		 << ", \"nps\": " << nodesPerSecond()
+		 << ", \"iterations\": [";
+	for (int depth = 1; depth < (int)iterationNodes.size(); depth++) {
+		if (depth > 1) json << ", ";
+		json << "{\"depth\": " << depth << ", \"nodes\": " << iterationNodes[depth] << ", \"branchingFactor\": " << branchingFactor(depth) << "}";
+	}
+	json << "]}";
+	return json.str();
+}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ChessProject {
+
+// Statistics about a search, to see where its time goes. Every search thread counts into its own copy, and the copies are added together
+//when the search finishes.
+struct SearchStats {
+	// Alpha-beta (interior) nodes and quiescence nodes visited.
+	unsigned long nodes;
+	unsigned long quiescenceNodes;
+	// Beta cutoffs in the alpha-beta search, and how many of those were caused by the first move searched. A high proportion of first move
+	//cutoffs means that moves are well ordered.
+	unsigned long betaCutoffs;
+	unsigned long firstMoveCutoffs;
+	// Principal variation search re-searches of moves that beat the null window, and root re-searches after a score fell outside the
+	//aspiration window.
+	unsigned long pvsResearches;
+	unsigned long aspirationResearches;
+	// Quiescence captures skipped by static exchange evaluation and by delta pruning.
+	unsigned long seePrunes;
+	unsigned long deltaPrunes;
+	// Nodes cut off by null move pruning, moves searched with a late move reduction, and reduced moves searched again at full depth.
+	unsigned long nullMoveCutoffs;
+	unsigned long reductions;
+	unsigned long lmrResearches;
+	// Nodes and evaluations answered by an endgame bitbase.
+	unsigned long bitbaseHits;
+	// The most plies searched beyond the alpha-beta search by quiescence.
+	int maxQuiescenceDepth;
+	// Wall-clock time of the search in milliseconds.
+	long time;
+	// The nodes (of both kinds) searched by each completed iteration of the main thread, indexed by depth. Index 0 is unused.
+	std::vector<unsigned long> iterationNodes;
+	SearchStats();
+	// Resets every statistic to zero.
+	void clear();
+	// Adds the counts of another thread's statistics to these. The time and iteration nodes are left alone, as they are only recorded by the
+	//main thread.
+	void add(const SearchStats &other);
+	// Returns the percentage of beta cutoffs that were caused by the first move.
+	double firstMoveCutoffRate() const;
+	// Returns the effective branching factor of an iteration: how many times more nodes it searched than the iteration before it. Returns 0
+	//for the first iteration, or for a depth that wasn't completed.
+	double branchingFactor(int depth) const;
+	// Returns the number of nodes of both kinds searched per second.
+	unsigned long nodesPerSecond() const;
+	// Returns the statistics as a JSON object.
+	std::string toJson() const;
+};
+
+}
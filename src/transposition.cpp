@@ -0,0 +1,96 @@
+#include "transposition.hpp"
+
+namespace ChessProject {
+
+bool TranspositionTable::Entry::isBestMove(const Move &move) const {
+	return bestFrom == move.subject_from && bestTo == move.subject_to && bestType == move.type;
+}
+
+TranspositionTable::Slot::Slot() :
+	check(0),
+	data(0) { }
+
+TranspositionTable::TranspositionTable(std::size_t sizeMB) {
+	resize(sizeMB);
+}
+
+void TranspositionTable::resize(std::size_t sizeMB) {
+	std::size_t maxSlots = (sizeMB * 1024 * 1024) / sizeof(Slot);
+	std::size_t numSlots = 1;
+	while (numSlots * 2 <= maxSlots) numSlots *= 2;
+	// Atomics can't be copied, so the new table is constructed in place and swapped in.
+	std::vector<Slot> newSlots(numSlots);
+	slots.swap(newSlots);
+	mask = numSlots - 1;
+}
+
+void TranspositionTable::clear() {
+	for (std::vector<Slot>::iterator slotItr = slots.begin(); slotItr != slots.end(); slotItr++) {
+		slotItr->check.store(0, std::memory_order_relaxed);
+		slotItr->data.store(0, std::memory_order_relaxed);
+	}
+}
+
+bool TranspositionTable::probe(hashkey key, Entry &entry) const {
+	const Slot &slot = slots[key & mask];
+	uint64_t data = slot.data.load(std::memory_order_relaxed);
+	if ((slot.check.load(std::memory_order_relaxed) ^ data) != key) return false;
+	entry = Unpack(key, data);
+	return entry.depth >= 0;
+}
+
+void TranspositionTable::store(hashkey key, int depth, int score, Bound bound, const Move &bestMove) {
+	Slot &slot = slots[key & mask];
+	Entry entry;
+	bool samePosition = probe(key, entry);
+	// Don't throw away a deeper search of the same position.
+	if (samePosition && entry.depth > depth) return;
+	// If this search didn't find a best move, keep the one from an earlier search of the same position.
+	if (bestMove.subject || !samePosition) {
+		entry.bestFrom = bestMove.subject_from;
+		entry.bestTo = bestMove.subject_to;
+		entry.bestType = bestMove.type;
+	}
+	entry.key = key;
+	entry.score = score;
+	entry.depth = depth;
+	entry.bound = bound;
+	uint64_t data = Pack(entry);
+	slot.check.store(key ^ data, std::memory_order_relaxed);
+	slot.data.store(data, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::CanCutoff(const Entry &entry, int depth, int alpha, int beta, int &score) {
+	if (entry.depth < depth) return false;
+	if (entry.bound == EXACT ||
+		(entry.bound == LOWER && entry.score >= beta) ||
+		(entry.bound == UPPER && entry.score <= alpha)) {
+		score = entry.score;
+		return true;
+	}
+	return false;
+}
+
+uint64_t TranspositionTable::Pack(const Entry &entry) {
+	// Bits 0-31: score. 32-39: depth + 1. 40-41: bound. 42-48: source + 1. 49-55: destination + 1. 56-58: move type.
+	return (uint64_t)(uint32_t)entry.score |
+		   ((uint64_t)(uint8_t)(entry.depth + 1) << 32) |
+		   ((uint64_t)(entry.bound & 3) << 40) |
+		   ((uint64_t)((entry.bestFrom + 1) & 127) << 42) |
+		   ((uint64_t)((entry.bestTo + 1) & 127) << 49) |
+		   ((uint64_t)(entry.bestType & 7) << 56);
+}
+
+TranspositionTable::Entry TranspositionTable::Unpack(hashkey key, uint64_t data) {
+	Entry entry;
+	entry.key = key;
+	entry.score = (int32_t)(uint32_t)data;
+	entry.depth = (int)((data >> 32) & 255) - 1;
+	entry.bound = (data >> 40) & 3;
+	entry.bestFrom = (int)((data >> 42) & 127) - 1;
+	entry.bestTo = (int)((data >> 49) & 127) - 1;
+	entry.bestType = (data >> 56) & 7;
+	return entry;
+}
+
+}
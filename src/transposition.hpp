@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "move.hpp"
+#include "position.hpp"
+#include "zobrist.hpp"
+
+namespace ChessProject {
+
+// The transposition table stores the results of positions that have already been searched, indexed by their Zobrist hash. The same position
+//is often reached through different orders of moves (a transposition), and a stored result can then either cut the search off immediately or
+//at least tell us which move to search first.
+// The table is shared between search threads without any locking. Each slot holds the packed entry and the hash XORed with the packed entry.
+//If two threads write to a slot at the same time, a reader will find that the two words no longer match and treat it as a miss.
+class TranspositionTable {
+public:
+	// The default size of the table in megabytes.
+	static const std::size_t DefaultSizeMB = 16;
+	// Alpha-beta search does not always return an exact score. This records what the stored score actually means.
+	enum Bound {
+		EXACT,
+		// The score is a lower bound (the search failed high - a beta cutoff occurred).
+		LOWER,
+		// The score is an upper bound (the search failed low - no move raised alpha).
+		UPPER
+	};
+	struct Entry {
+		hashkey key;
+		int score;
+		// The depth that the position was searched to. Quiescence results are stored with a depth of 0, and empty slots have a depth of -1.
+		signed char depth;
+		unsigned char bound;
+		// The best move found is stored by its source, destination and move type. It must be matched against a generated move list before use.
+		signed char bestFrom, bestTo;
+		unsigned char bestType;
+		// Returns true if the stored best move matches the given move.
+		bool isBestMove(const Move &move) const;
+	};
+	TranspositionTable(std::size_t sizeMB = DefaultSizeMB);
+	// Resizes the table to the largest power of two number of entries that fits in the given number of megabytes. Clears the table.
+	// Must not be called during a search.
+	void resize(std::size_t sizeMB);
+	// Empties every entry in the table.
+	void clear();
+	// Copies the entry stored for this hash into entry. Returns false if there is none.
+	bool probe(hashkey key, Entry &entry) const;
+	// Stores the result of a search. An existing entry for the same position is only replaced by one that has been searched at least as deep.
+	void store(hashkey key, int depth, int score, Bound bound, const Move &bestMove);
+	// Returns true if a stored entry is deep enough and has a bound that allows a cutoff in an (alpha, beta) window. Sets score if so.
+	static bool CanCutoff(const Entry &entry, int depth, int alpha, int beta, int &score);
+private:
+	struct Slot {
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;
+		Slot();
+	};
+	std::vector<Slot> slots;
+	// The number of slots minus one. Used to map a hash onto an index.
+	std::size_t mask;
+	// Converts entries to and from the single 64-bit word they are stored as.
+	static uint64_t Pack(const Entry &entry);
+	static Entry Unpack(hashkey key, uint64_t data);
+};
+
+}
@@ -0,0 +1,235 @@
+#include "uci.hpp"
+
+namespace ChessProject {
+
+const std::string Uci::EngineName = "Third Year Chess Project";
+const std::string Uci::EngineAuthor = "Third Year Chess Project contributors";
+const int Uci::MaxHashMB;
+const int Uci::MaxThreads;
+
+Uci::Uci() :
+	threads(1),
+	nullMove(true),
+	lateMoveReductions(true),
+	ownBook(false),
+	stopSearch(false),
+	out(&std::cout) {
+	board.init();
+	info.init();
+}
+
+Uci::~Uci() {
+	stop();
+}
+
+void Uci::loop(std::istream &in, std::ostream &out) {
+	this->out = &out;
+	std::string line;
+	while (std::getline(in, line)) {
+		std::istringstream args(line);
+		std::string command;
+		args >> command;
+		if (command == "uci") {
+			send("id name " + EngineName);
+			send("id author " + EngineAuthor);
+			std::ostringstream options;
+			options << "option name Hash type spin default " << TranspositionTable::DefaultSizeMB << " min 1 max " << MaxHashMB;
+			send(options.str());
+			options.str("");
+			options << "option name Threads type spin default 1 min 1 max " << MaxThreads;
+			send(options.str());
+			send("option name NullMove type check default true");
+			send("option name LateMoveReductions type check default true");
+			send("option name OwnBook type check default false");
+			send("option name BookFile type string default <empty>");
+			send("option name BitbasePath type string default <empty>");
+			send("option name EvalFile type string default <empty>");
+			send("uciok");
+		} else if (command == "isready") {
+			send("readyok");
+		} else if (command == "setoption") {
+			setOption(args);
+		} else if (command == "ucinewgame") {
+			stop();
+			Minimax::Table.clear();
+			board.init();
+			info.init();
+		} else if (command == "position") {
+			position(args);
+		} else if (command == "go") {
+			go(args);
+		} else if (command == "stop") {
+			stop();
+		} else if (command == "quit") {
+			break;
+		}
+	}
+	stop();
+}
+
+void Uci::send(const std::string &line) {
+	std::lock_guard<std::mutex> lock(outputMutex);
+	*out << line << std::endl;
+}
+
+void Uci::setOption(std::istringstream &args) {
+	// The syntax is "setoption name <id> value <x>".
+	std::string token, name, value;
+	args >> token >> name >> token >> value;
+	// No option can change during a search.
+	stop();
+	if (name == "Hash") {
+		int sizeMB = std::min(std::max(std::atoi(value.c_str()), 1), MaxHashMB);
+		Minimax::Table.resize(sizeMB);
+	} else if (name == "Threads") {
+		threads = std::min(std::max(std::atoi(value.c_str()), 1), MaxThreads);
+	} else if (name == "NullMove") {
+		nullMove = (value == "true");
+	} else if (name == "LateMoveReductions") {
+		lateMoveReductions = (value == "true");
+	} else if (name == "OwnBook") {
+		ownBook = (value == "true");
+	} else if (name == "BookFile") {
+		Book::OpenResult result = book.open(value);
+		if (result == Book::CANT_READ) send("info string can't open book " + value);
+		else if (result == Book::WRONG_FORMAT) send("info string " + value + " is not a book made by the book tool (Polyglot books aren't supported)");
+	} else if (name == "BitbasePath") {
+		std::ostringstream loaded;
+		loaded << "info string loaded " << Bitbase::Load(value) << " bitbases";
+		send(loaded.str());
+	} else if (name == "EvalFile") {
+		if (!EvalParams::Load(value)) {
+			send("info string can't load eval file " + value);
+			return;
+		}
+		// Scores in the table are from the old weights, and the board's running totals of material and piece square bonuses have to be
+		//summed again.
+		Minimax::Table.clear();
+		Fen::Load(Fen::Save(&board, &info), &board, &info);
+	}
+}
+
+void Uci::position(std::istringstream &args) {
+	stop();
+	// If any of the moves is illegal, the whole command is rejected and the position from before it is kept.
+	Board previousBoard = board;
+	GameInfo previousInfo = info;
+	std::string token;
+	args >> token;
+	if (token == "fen") {
+		// The FEN string runs until the list of moves, if there is one.
+		std::string fen;
+		while (args >> token && token != "moves") fen += token + " ";
+		if (!Fen::Load(fen, &board, &info)) {
+			send("info string invalid fen " + fen);
+			board.init();
+			info.init();
+			return;
+		}
+	} else {
+		board.init();
+		info.init();
+		args >> token;
+	}
+	if (token != "moves") return;
+	while (args >> token) {
+		Move move;
+		if (!parseMove(token, move)) {
+			send("info string illegal move " + token);
+			board = previousBoard;
+			info = previousInfo;
+			return;
+		}
+		board.executeMove(move);
+		info.executeMove(move);
+	}
+}
+
+void Uci::go(std::istringstream &args) {
+	stop();
+	Minimax::Limits limits;
+	limits.threads = threads;
+	limits.nullMove = nullMove;
+	limits.lmr = lateMoveReductions;
+	long clockTime[NUM_COLORS] = { 0, 0 };
+	long increment[NUM_COLORS] = { 0, 0 };
+	int movesToGo = DefaultMovesToGo;
+	bool infinite = false;
+	std::string token;
+	while (args >> token) {
+		if (token == "depth") args >> limits.depth;
+		else if (token == "nodes") args >> limits.nodes;
+		else if (token == "movetime") args >> limits.time;
+		else if (token == "wtime") args >> clockTime[Piece::WHITE];
+		else if (token == "btime") args >> clockTime[Piece::BLACK];
+		else if (token == "winc") args >> increment[Piece::WHITE];
+		else if (token == "binc") args >> increment[Piece::BLACK];
+		else if (token == "movestogo") args >> movesToGo;
+		else if (token == "infinite") infinite = true;
+	}
+	Move bookMove;
+	if (ownBook && !infinite && book.probe(&board, &info, bookMove)) {
+		send("info string book move");
+		send("bestmove " + bookMove.toAlgebraic());
+		return;
+	}
+	// When playing on a clock, use an equal share of the remaining time plus most of the increment, without ever running the clock down.
+	if (limits.time == 0 && clockTime[info.turn] > 0) {
+		long available = std::max(clockTime[info.turn] - MoveOverhead, 1L);
+		limits.time = std::min(available / std::max(movesToGo, 1) + increment[info.turn] * 3 / 4, available);
+	}
+	stopSearch = false;
+	limits.stop = &stopSearch;
+	searchThread = std::thread(&Uci::search, this, limits, infinite);
+}
+
+void Uci::stop() {
+	if (!searchThread.joinable()) return;
+	stopSearch = true;
+	searchThread.join();
+}
+
+void Uci::search(Minimax::Limits limits, bool infinite) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Move bestMove;
+	Minimax::Search(&board, &info, bestMove, limits, [&](int depth, int score, const Move &move) {
+		long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		unsigned long nodes = Minimax::NodeCount();
+		std::ostringstream line;
+		line << "info depth " << depth << " score " << FormatScore(score) << " nodes " << nodes
+			 << " nps " << nodes * 1000 / std::max(elapsed, 1L) << " time " << elapsed;
+		// A game that is already over has no move to report.
+		if (move.subject) line << " pv " << move.toAlgebraic();
+		send(line.str());
+	});
+	// An infinite search can run out of depth, or find nothing to search, before it is told to stop. The move is only reported once it is.
+	while (infinite && !stopSearch) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	// There is no legal move if the game is already over.
+	send("bestmove " + (bestMove.subject ? bestMove.toAlgebraic() : std::string("0000")));
+}
+
+std::string Uci::FormatScore(int score) {
+	std::ostringstream text;
+	if (std::abs(score) >= LARGEST_NUM) text << "cp 0";
+	// Mate scores count plies, and UCI counts moves.
+	else if (score >= MATE_BOUND) text << "mate " << (LARGE_NUM - score + 1) / 2;
+	else if (score <= -MATE_BOUND) text << "mate " << -(LARGE_NUM + score) / 2;
+	else text << "cp " << score;
+	return text.str();
+}
+
+bool Uci::parseMove(const std::string &str, Move &move) {
+	// Every legal move is generated, even in a position that is already drawn by insufficient material or the fifty move rule, which
+	//updateState would leave with no moves.
+	MoveList moveList;
+	moveList.generateLegal(info.turn, &board, &info, ~(bitboard64)0, true, true);
+	for (MoveList::iterator moveItr = moveList.begin(); moveItr != moveList.end(); moveItr++) {
+		if (moveItr->toAlgebraic() == str) {
+			move = *moveItr;
+			return true;
+		}
+	}
+	return false;
+}
+
+}
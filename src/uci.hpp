@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "bitbase.hpp"
+#include "board.hpp"
+#include "book.hpp"
+#include "evalparams.hpp"
+#include "fen.hpp"
+#include "gameinfo.hpp"
+#include "minimax.hpp"
+#include "movelist.hpp"
+
+namespace ChessProject {
+
+// Implements the Universal Chess Interface (UCI) protocol, which lets the engine be driven by chess GUIs and tools over stdin/stdout.
+//Supported commands are uci, isready, setoption (Hash, Threads, NullMove, LateMoveReductions, OwnBook and BookFile), ucinewgame, position, go,
+//stop and quit.
+// Searches run on a separate thread, so that commands such as stop and isready are answered while the engine is thinking.
+class Uci {
+public:
+	static const std::string EngineName;
+	static const std::string EngineAuthor;
+	// Limits on the UCI options.
+	static const int MaxHashMB = 4096;
+	static const int MaxThreads = 256;
+	// Milliseconds kept in reserve when thinking on a clock, to allow for communication delays.
+	static const long MoveOverhead = 50;
+	// If the number of moves until the next time control isn't given, the remaining time is shared between this many moves.
+	static const int DefaultMovesToGo = 30;
+	Uci();
+	~Uci();
+	// Reads and executes commands until quit is received or the input ends.
+	void loop(std::istream &in, std::ostream &out);
+private:
+	Board board;
+	GameInfo info;
+	int threads;
+	bool nullMove, lateMoveReductions;
+	// With OwnBook set, go plays straight from the opening book whenever the position is in it, instead of searching.
+	Book book;
+	bool ownBook;
+	std::thread searchThread;
+	// Set by stop to end the search on searchThread. Cleared before every search starts, so it only ever stops the one it was set for.
+	std::atomic<bool> stopSearch;
+	// Guards the output stream, which is written to by both the search thread and the command loop.
+	std::mutex outputMutex;
+	std::ostream *out;
+	void send(const std::string &line);
+	void setOption(std::istringstream &args);
+	// Sets up a position: "position [startpos | fen <fen>] [moves <move1> ... <moveN>]". If a move is illegal, the position is left as it
+	//was before the command.
+	void position(std::istringstream &args);
+	// Starts a search: "go [depth <d>] [nodes <n>] [movetime <ms>] [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [infinite]".
+	//The book is not used for an infinite search, which must not report a move until it is stopped.
+	void go(std::istringstream &args);
+	// Stops any running search and waits for it to report its best move.
+	void stop();
+	// The search thread. Reports each completed iteration and then the best move, which an infinite search holds back until stopped.
+	void search(Minimax::Limits limits, bool infinite);
+	// Formats a search score for an info line: "cp <centipawns>" or "mate <moves>", negative if the engine is being mated. A draw, which
+	//the search scores beyond LARGEST_NUM, is reported as "cp 0".
+	static std::string FormatScore(int score);
+	// Finds the legal move with the given long algebraic notation. Returns false if there is no such move.
+	bool parseMove(const std::string &str, Move &move);
+};
+
+}
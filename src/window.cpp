@@ -20,6 +20,8 @@ bool Window::init() {
 	// Game menu
 	gameMenu.items().push_back(Gtk::Menu_Helpers::MenuElem("_New", Gtk::AccelKey('n', Gdk::CONTROL_MASK),
 		sigc::mem_fun(gui, &Gui::newGame)));
+	gameMenu.items().push_back(Gtk::Menu_Helpers::MenuElem("_Stop / move now", Gtk::AccelKey('m', Gdk::CONTROL_MASK),
+		sigc::mem_fun(gui, &Gui::stopSearch)));
 	gameMenu.items().push_back(Gtk::Menu_Helpers::MenuElem("_Quit", Gtk::AccelKey('q', Gdk::CONTROL_MASK),
 		sigc::mem_fun(*this, &Window::hide)));
 	gameMenu.items().push_back(Gtk::Menu_Helpers::MenuElem("Select _White player", Gtk::AccelKey(),
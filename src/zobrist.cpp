@@ -0,0 +1,46 @@
+#include "zobrist.hpp"
+
+namespace ChessProject {
+
+hashkey Zobrist::PieceSquare[NUM_COLORS][NUM_PIECE_TYPES][BOARDSIZE];
+hashkey Zobrist::Turn;
+hashkey Zobrist::Castling[NUM_CASTLING_STATES];
+hashkey Zobrist::EnPassant[NUM_FILES];
+hashkey Zobrist::FiftyMove[FIFTY_MOVE_HASH_HORIZON + 1];
+
+// A fixed seed is used so that hashes are reproducible between runs.
+hashkey Zobrist::Seed = 0x9E3779B97F4A7C15ULL;
+
+void Zobrist::Precalculate() {
+	for (int color = 0; color < NUM_COLORS; color++) {
+		for (int type = 0; type < NUM_PIECE_TYPES; type++) {
+			for (position pos = 0; pos < BOARDSIZE; pos++) {
+				PieceSquare[color][type][pos] = Random64();
+			}
+		}
+	}
+	Turn = Random64();
+	// No castling unavailability is represented by a zero key, so that the initial position only depends on the pieces.
+	Castling[0] = 0;
+	for (int i = 1; i < NUM_CASTLING_STATES; i++) Castling[i] = Random64();
+	for (int file = 0; file < NUM_FILES; file++) EnPassant[file] = Random64();
+	FiftyMove[0] = 0;
+	for (int i = 1; i <= FIFTY_MOVE_HASH_HORIZON; i++) FiftyMove[i] = Random64();
+}
+
+hashkey Zobrist::FiftyMoveKey(int fiftyMoveRuleCounter) {
+	int i = fiftyMoveRuleCounter - (100 - FIFTY_MOVE_HASH_HORIZON);
+	if (i <= 0) return FiftyMove[0];
+	if (i > FIFTY_MOVE_HASH_HORIZON) i = FIFTY_MOVE_HASH_HORIZON;
+	return FiftyMove[i];
+}
+
+hashkey Zobrist::Random64() {
+	// xorshift64* pseudo-random number generator.
+	Seed ^= Seed >> 12;
+	Seed ^= Seed << 25;
+	Seed ^= Seed >> 27;
+	return Seed * 0x2545F4914F6CDD1DULL;
+}
+
+}
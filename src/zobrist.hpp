@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include "piece.hpp"
+#include "position.hpp"
+
+#define NUM_CASTLING_STATES 16
+// The fifty move rule counter only affects the hash once it gets within this many plies of a draw.
+#define FIFTY_MOVE_HASH_HORIZON 20
+
+namespace ChessProject {
+
+typedef uint64_t hashkey;
+
+// Zobrist hashing assigns a random 64-bit key to every feature of a position (a piece on a square, the side to move, etc.). The hash of a
+//position is the XOR of the keys of all its features, which means it can be updated incrementally whenever a feature is added or removed.
+struct Zobrist {
+	// One key for every piece type of every color on every square.
+	static hashkey PieceSquare[NUM_COLORS][NUM_PIECE_TYPES][BOARDSIZE];
+	// XORed into the hash when it is black's turn to move.
+	static hashkey Turn;
+	// One key for every combination of the 4 castling unavailability bits.
+	static hashkey Castling[NUM_CASTLING_STATES];
+	// One key for the file of the en passant target.
+	static hashkey EnPassant[NUM_FILES];
+	// The fifty move rule counter is only hashed when it is close enough to 100 for the rule to affect a search. Hashing it any earlier would
+	//stop transpositions that differ only in when a pawn was pushed from sharing entries.
+	static hashkey FiftyMove[FIFTY_MOVE_HASH_HORIZON + 1];
+	// Precalculates all keys. Must be executed before any hashing.
+	static void Precalculate();
+	// Returns the key for the given fifty move rule counter.
+	static hashkey FiftyMoveKey(int fiftyMoveRuleCounter);
+private:
+	static hashkey Seed;
+	static hashkey Random64();
+};
+
+}
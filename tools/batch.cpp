@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bitbase.hpp"
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "fen.hpp"
+#include "gameinfo.hpp"
+#include "minimax.hpp"
+#include "zobrist.hpp"
+using namespace ChessProject;
+
+// Batch analysis searches every position in a file of FEN or EPD positions, one per line, and writes the results in the same order as the
+//input. Every thread searches a different position, so a large file keeps every core busy without any of the overhead of searching one
+//position on several threads.
+// Usage: batch [-d depth] [-n nodes] [-t milliseconds] [--hash megabytes] [--threads n] [--bitbases directory] [file]
+// Positions are read from standard input if no file is given. Each result is an EPD line holding the position, any operations it had in
+//the input, and the best move (pv), score in centipawns for the side to move (ce), depth (acd), nodes (acn) and seconds (acs) of the
+//search. Lines that aren't valid positions are written back unchanged.
+// The transposition table is shared by every search, so the results can vary slightly with the number of threads and the order of the
+//positions.
+
+namespace {
+
+// The default search depth if no limit is given.
+const int DefaultDepth = 8;
+// The most lines read ahead of the oldest one that hasn't been written yet. Reading stops until it has been, so that a huge file is never
+//held in memory, and one slow position can't leave the output buffer growing without bound.
+const unsigned long MaxBuffered = 4096;
+
+struct Job {
+	unsigned long index;
+	std::string line;
+	// The position fields and move counters, and the EPD operations that followed them.
+	std::string position;
+	std::string operations;
+};
+
+// Every worker has its own queue of jobs. The reader deals jobs out to the queues in turn. A worker takes jobs from the front of its own
+//queue, and once that is empty steals from the back of the others, so no worker sits idle while there are positions waiting.
+struct WorkQueue {
+	std::deque<Job> jobs;
+	std::mutex mutex;
+};
+
+std::vector<WorkQueue> *queues = 0;
+Minimax::Limits limits;
+// Jobs waiting in the queues, and whether the whole input has been read. Idle workers sleep on workAvailable until either changes.
+unsigned long pending = 0;
+bool inputDone = false;
+std::mutex workMutex;
+std::condition_variable workAvailable;
+// Results that are finished but waiting for an earlier line to be written, by line index.
+std::map<unsigned long, std::string> finished;
+unsigned long written = 0;
+std::mutex outputMutex;
+std::condition_variable outputWritten;
+
+// Splits a line into the position fields and move counters that Fen::Load reads, and the EPD operations after them. The move counters are
+//only taken if both are there, as EPD doesn't have them.
+void splitLine(const std::string &line, std::string &position, std::string &operations) {
+	std::istringstream stream(line);
+	std::string field;
+	for (int i = 0; i < 4 && stream >> field; i++) position += (i > 0 ? " " : "") + field;
+	std::streampos end = stream.tellg();
+	int halfmove, fullmove;
+	if (end >= 0 && stream >> halfmove >> fullmove) {
+		std::ostringstream counters;
+		counters << ' ' << halfmove << ' ' << fullmove;
+		position += counters.str();
+		end = stream.tellg();
+	}
+	operations = end >= 0 ? line.substr(end) : "";
+	std::string::size_type first = operations.find_first_not_of(" \t\r");
+	operations = first == std::string::npos ? "" : operations.substr(first, operations.find_last_not_of(" \t\r") - first + 1);
+}
+
+// Stores the output line of the job with the given index, then writes every line that is now next in order.
+void writeResult(unsigned long index, const std::string &line) {
+	std::lock_guard<std::mutex> lock(outputMutex);
+	finished[index] = line;
+	while (!finished.empty() && finished.begin()->first == written) {
+		std::cout << finished.begin()->second << std::endl;
+		finished.erase(finished.begin());
+		written++;
+	}
+	outputWritten.notify_all();
+}
+
+void addJob(int worker, const Job &job) {
+	WorkQueue &queue = (*queues)[worker];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+	std::lock_guard<std::mutex> lock(workMutex);
+	pending++;
+	workAvailable.notify_one();
+}
+
+// Takes the next job for a worker, from its own queue if it can, or else from another worker's. Returns false if every queue is empty.
+bool takeJob(int worker, Job &job) {
+	int numQueues = queues->size();
+	for (int i = 0; i < numQueues; i++) {
+		WorkQueue &queue = (*queues)[(worker + i) % numQueues];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty()) continue;
+		if (i == 0) {
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+		} else {
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+		}
+		std::lock_guard<std::mutex> workLock(workMutex);
+		pending--;
+		return true;
+	}
+	return false;
+}
+
+std::string analyse(const Job &job, Board *board, GameInfo *info) {
+	if (!Fen::Load(job.position, board, info)) {
+		if (job.line.find_first_not_of(" \t\r") != std::string::npos) {
+			std::cerr << "Invalid position on line " << job.index + 1 << ": " << job.line << std::endl;
+		}
+		return job.line;
+	}
+	Move move;
+	SearchStats stats;
+	int score = Minimax::Search(board, info, move, limits, Minimax::IterationCallback(), &stats);
+	// The EPD position is the first four fields, without the move counters.
+	std::istringstream fields(job.position);
+	std::string field;
+	std::ostringstream result;
+	for (int i = 0; i < 4 && fields >> field; i++) result << (i > 0 ? " " : "") << field;
+	if (!job.operations.empty()) result << ' ' << job.operations;
+	// There is no best move if the game is already over. The search scores a draw above LARGEST_NUM, so that it is disregarded, and a
+	//position where every move is disregarded scores -LARGEST_NUM. Both are reported as draws.
+	if (move.subject) result << " pv " << move.toAlgebraic() << ";";
+	result << " ce " << (std::abs(score) >= LARGEST_NUM ? 0 : score) << "; acd " << stats.iterationNodes.size() - 1
+		   << "; acn " << stats.nodes + stats.quiescenceNodes << "; acs " << std::fixed << std::setprecision(3) << stats.time / 1000.0 << ";";
+	return result.str();
+}
+
+void work(int worker) {
+	Board board;
+	GameInfo info;
+	while (true) {
+		Job job;
+		if (takeJob(worker, job)) {
+			writeResult(job.index, analyse(job, &board, &info));
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(workMutex);
+		while (pending == 0 && !inputDone) workAvailable.wait(lock);
+		if (pending == 0 && inputDone) return;
+	}
+}
+
+void usage() {
+	std::cerr << "Usage: batch [-d depth] [-n nodes] [-t milliseconds] [--hash megabytes] [--threads n] [--bitbases directory] [file]"
+			  << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+	Bitboard::Precalculate();
+	Zobrist::Precalculate();
+	int depth = 0;
+	int hashMB = 0;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	std::string path, bitbaseDirectory;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "-d" && hasValue) depth = std::atoi(argv[++i]);
+		else if (arg == "-n" && hasValue) limits.nodes = std::strtoul(argv[++i], 0, 10);
+		else if (arg == "-t" && hasValue) limits.time = std::atol(argv[++i]);
+		else if (arg == "--hash" && hasValue) hashMB = std::atoi(argv[++i]);
+		else if (arg == "--threads" && hasValue) threads = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--bitbases" && hasValue) bitbaseDirectory = argv[++i];
+		else if (arg[0] != '-' && path.empty()) path = arg;
+		else {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (depth == 0 && limits.nodes == 0 && limits.time == 0) depth = DefaultDepth;
+	limits.depth = depth > 0 ? depth : MAX_DEPTH;
+	std::ifstream file;
+	if (!path.empty()) {
+		file.open(path.c_str());
+		if (!file) {
+			std::cerr << "Can't open " << path << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	std::istream &input = path.empty() ? std::cin : file;
+	if (hashMB > 0) Minimax::Table.resize(hashMB);
+	if (!bitbaseDirectory.empty() && Bitbase::Load(bitbaseDirectory) == 0) {
+		std::cerr << "No bitbases in " << bitbaseDirectory << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::vector<WorkQueue> workQueues(threads);
+	queues = &workQueues;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; i++) workers.push_back(std::thread(work, i));
+	Job job;
+	job.index = 0;
+	while (std::getline(input, job.line)) {
+		{
+			std::unique_lock<std::mutex> lock(outputMutex);
+			while (job.index - written >= MaxBuffered) outputWritten.wait(lock);
+		}
+		job.position.clear();
+		splitLine(job.line, job.position, job.operations);
+		addJob(job.index % threads, job);
+		job.index++;
+	}
+	{
+		std::lock_guard<std::mutex> lock(workMutex);
+		inputDone = true;
+		workAvailable.notify_all();
+	}
+	for (std::vector<std::thread>::iterator workerItr = workers.begin(); workerItr != workers.end(); workerItr++) {
+		workerItr->join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Analysed " << job.index << " lines in " << seconds << " s" << std::endl;
+	return EXIT_SUCCESS;
+}
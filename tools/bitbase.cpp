@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#include "bitbase.hpp"
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "fen.hpp"
+#include "gameinfo.hpp"
+#include "movelist.hpp"
+#include "zobrist.hpp"
+using namespace ChessProject;
+
+// Generates the endgame bitbases by retrograde analysis. Pass 0 finds the positions where the weak king is checkmated. Each pass after
+//that finds the positions won or lost in one more ply: on odd plies, strong side to move positions with a move to a loss found by the
+//last pass, and on even plies, weak side to move positions where every move leads to a win. Whatever is left once no pass finds anything
+//is a draw.
+// A pass only writes positions with one side to move and only reads positions with the other, so the positions are shared out between
+//threads without any locking. Moves are generated straight from the squares of a position with the Bitboard attack tables, as setting up
+//a Board for each of the millions of positions every pass would be far too slow. --verify checks the result against Board and MoveList.
+// Usage: bitbase [-o directory] [--threads n] [--verify positions]
+
+namespace {
+
+std::vector<unsigned char> tables[Bitbase::NUM_MATERIALS];
+int threads = 1;
+
+// Returns the type of the piece at an index of a position's squares.
+Piece::Type pieceType(Bitbase::Material material, int i) {
+	if (i == 0 || i == Bitbase::NumStrongPieces(material)) return Piece::KING;
+	return Bitbase::Pieces[material][i - 1];
+}
+
+// Returns the squares attacked by the strong side's pieces, leaving out the piece at index skip. Tables are from the strong side's point
+//of view, so its pawns attack up the board like white's.
+bitboard64 strongAttacks(Bitbase::Material material, const position *squares, bitboard64 occupied, int skip) {
+	bitboard64 attacks = 0;
+	for (int i = 0; i < Bitbase::NumStrongPieces(material); i++) {
+		if (i == skip) continue;
+		position pos = squares[i];
+		switch (pieceType(material, i)) {
+			case Piece::KING: attacks |= Bitboard::KingAttacks[pos]; break;
+			case Piece::KNIGHT: attacks |= Bitboard::KnightAttacks[pos]; break;
+			case Piece::BISHOP: attacks |= Bitboard::BishopAttacks(pos, occupied); break;
+			case Piece::ROOK: attacks |= Bitboard::RookAttacks(pos, occupied); break;
+			case Piece::QUEEN: attacks |= Bitboard::BishopAttacks(pos, occupied) | Bitboard::RookAttacks(pos, occupied); break;
+			case Piece::PAWN: attacks |= Bitboard::PawnAttacks[Piece::WHITE][pos]; break;
+			default: break;
+		}
+	}
+	return attacks;
+}
+
+bitboard64 occupancy(Bitbase::Material material, const position *squares) {
+	bitboard64 occupied = 0;
+	for (int i = 0; i <= Bitbase::NumStrongPieces(material); i++) occupied |= Bitboard::Square(squares[i]);
+	return occupied;
+}
+
+// A position is illegal if two pieces share a square, the kings are next to each other, or the side not to move is in check.
+bool isLegal(Bitbase::Material material, bool strongToMove, const position *squares) {
+	int numStrong = Bitbase::NumStrongPieces(material);
+	bitboard64 occupied = occupancy(material, squares);
+	if (__builtin_popcountll(occupied) != numStrong + 1) return false;
+	if (Bitboard::KingAttacks[squares[0]] & Bitboard::Square(squares[numStrong])) return false;
+	return !strongToMove || !(strongAttacks(material, squares, occupied, -1) & Bitboard::Square(squares[numStrong]));
+}
+
+// Returns true if a table value is a loss (for the weak side to move) or win (for the strong side to move) in under ply plies.
+bool resolvedBefore(unsigned char value, int ply) {
+	return value != Bitbase::Draw && value != Bitbase::Illegal && value <= ply;
+}
+
+// Returns ply + 1 if the strong side to move can reach a position lost in under ply plies, or 0 otherwise.
+unsigned char strongValue(Bitbase::Material material, const position *squares, int ply) {
+	const std::vector<unsigned char> &table = tables[material];
+	int numStrong = Bitbase::NumStrongPieces(material);
+	bitboard64 occupied = occupancy(material, squares);
+	position child[MAX_BITBASE_PIECES];
+	std::copy(squares, squares + numStrong + 1, child);
+	for (int i = 0; i < numStrong; i++) {
+		Piece::Type type = pieceType(material, i);
+		bitboard64 targets;
+		if (type == Piece::PAWN) {
+			// Single and double pushes. There is nothing for a pawn to capture but the king.
+			targets = Bitboard::Square(squares[i] + NUM_FILES) & ~occupied;
+			if (targets && Position::Rank(squares[i]) == 1) targets |= Bitboard::Square(squares[i] + 2 * NUM_FILES) & ~occupied;
+		} else {
+			targets = 0;
+			switch (type) {
+				case Piece::KING: targets = Bitboard::KingAttacks[squares[i]] & ~Bitboard::KingAttacks[squares[numStrong]]; break;
+				case Piece::KNIGHT: targets = Bitboard::KnightAttacks[squares[i]]; break;
+				case Piece::BISHOP: targets = Bitboard::BishopAttacks(squares[i], occupied); break;
+				case Piece::ROOK: targets = Bitboard::RookAttacks(squares[i], occupied); break;
+				case Piece::QUEEN: targets = Bitboard::BishopAttacks(squares[i], occupied) | Bitboard::RookAttacks(squares[i], occupied); break;
+				default: break;
+			}
+			targets &= ~occupied;
+		}
+		while (targets) {
+			child[i] = Bitboard::PopFirst(targets);
+			if (type == Piece::PAWN && Position::Rank(child[i]) == NUM_RANKS - 1) {
+				// Only a queen or rook can win, and their tables are already complete. The other promotions draw.
+				if (resolvedBefore(tables[Bitbase::KQK][Bitbase::Index(Bitbase::KQK, false, child)], ply) ||
+					resolvedBefore(tables[Bitbase::KRK][Bitbase::Index(Bitbase::KRK, false, child)], ply)) {
+					return ply + 1;
+				}
+			} else if (resolvedBefore(table[Bitbase::Index(material, false, child)], ply)) {
+				return ply + 1;
+			}
+		}
+		child[i] = squares[i];
+	}
+	return 0;
+}
+
+// Returns ply + 1 if the weak side to move is checkmated (on ply 0), or has a legal move and every legal move leads to a position won in
+//under ply plies. Returns 0 otherwise.
+unsigned char weakValue(Bitbase::Material material, const position *squares, int ply) {
+	const std::vector<unsigned char> &table = tables[material];
+	int numStrong = Bitbase::NumStrongPieces(material);
+	position king = squares[numStrong];
+	// The king doesn't block attacks on the squares behind it.
+	bitboard64 occupied = occupancy(material, squares) & ~Bitboard::Square(king);
+	bitboard64 attacked = strongAttacks(material, squares, occupied, -1);
+	bitboard64 targets = Bitboard::KingAttacks[king] & ~attacked;
+	position child[MAX_BITBASE_PIECES];
+	std::copy(squares, squares + numStrong + 1, child);
+	int numMoves = 0;
+	while (targets) {
+		position to = Bitboard::PopFirst(targets);
+		// Capturing an undefended piece leaves too little material to win.
+		if (occupied & Bitboard::Square(to)) return 0;
+		numMoves++;
+		child[numStrong] = to;
+		if (!resolvedBefore(table[Bitbase::Index(material, true, child)], ply)) return 0;
+	}
+	if (numMoves == 0) return (ply == 0 && (attacked & Bitboard::Square(king))) ? 1 : 0;
+	return ply + 1;
+}
+
+// Runs one pass over a slice of a table, and counts the positions it resolves. Pass -1 marks the illegal positions.
+void runPass(Bitbase::Material material, int ply, int begin, int end, unsigned long *resolved) {
+	std::vector<unsigned char> &table = tables[material];
+	bool strongToMove;
+	position squares[MAX_BITBASE_PIECES];
+	for (int index = begin; index < end; index++) {
+		if (table[index] != Bitbase::Draw) continue;
+		Bitbase::Decode(material, index, strongToMove, squares);
+		if (ply < 0) {
+			if (!isLegal(material, strongToMove, squares)) table[index] = Bitbase::Illegal;
+			continue;
+		}
+		// Even plies resolve positions with the weak side to move, and odd plies with the strong side to move.
+		if (strongToMove != (ply % 2 == 1)) continue;
+		unsigned char value = strongToMove ? strongValue(material, squares, ply) : weakValue(material, squares, ply);
+		if (value != Bitbase::Draw) {
+			table[index] = value;
+			(*resolved)++;
+		}
+	}
+}
+
+// Runs a pass over the whole table, split between the threads. Returns the number of positions resolved.
+unsigned long runParallelPass(Bitbase::Material material, int ply) {
+	int size = Bitbase::Size(material);
+	std::vector<unsigned long> resolved(threads, 0);
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; i++) {
+		int begin = (int)((long long)size * i / threads), end = (int)((long long)size * (i + 1) / threads);
+		workers.push_back(std::thread(runPass, material, ply, begin, end, &resolved[i]));
+	}
+	unsigned long total = 0;
+	for (int i = 0; i < threads; i++) {
+		workers[i].join();
+		total += resolved[i];
+	}
+	return total;
+}
+
+void generate(Bitbase::Material material) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	tables[material].assign(Bitbase::Size(material), Bitbase::Draw);
+	runParallelPass(material, -1);
+	// A pawn can reach a position lost in many plies by promoting, so passes can't stop while a promotion might still resolve a position.
+	int minPlies = 0;
+	if (material == Bitbase::KPK) {
+		for (int other = Bitbase::KQK; other <= Bitbase::KRK; other++) {
+			std::vector<unsigned char> &table = tables[other];
+			for (std::size_t i = 0; i < table.size(); i++) {
+				if (table[i] != Bitbase::Illegal) minPlies = std::max(minPlies, (int)table[i]);
+			}
+		}
+	}
+	int ply = 0, idlePasses = 0, longest = 0;
+	for (; ply < Bitbase::Illegal - 1 && (idlePasses < 2 || ply <= minPlies); ply++) {
+		if (runParallelPass(material, ply) > 0) {
+			idlePasses = 0;
+			longest = ply;
+		} else {
+			idlePasses++;
+		}
+	}
+	unsigned long wins = 0, losses = 0, draws = 0;
+	for (int index = 0; index < Bitbase::Size(material); index++) {
+		unsigned char value = tables[material][index];
+		if (value == Bitbase::Illegal) continue;
+		if (value == Bitbase::Draw) draws++;
+		// The odd values are one more than an even number of plies, which always ends with the weak side to move.
+		else if (value % 2 == 0) wins++;
+		else losses++;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << Bitbase::Names[material] << ": " << wins << " wins, " << losses << " losses, " << draws << " draws, longest mate "
+			  << longest << " plies, " << seconds << " s" << std::endl;
+}
+
+// Returns the FEN of a table position, with the strong side's pieces in the given color. Black's pieces are seen from the other side of
+//the board.
+std::string toFen(Bitbase::Material material, bool strongToMove, const position *squares, Piece::Color strong) {
+	char board[BOARDSIZE];
+	std::fill(board, board + BOARDSIZE, '.');
+	int numStrong = Bitbase::NumStrongPieces(material);
+	for (int i = 0; i <= numStrong; i++) {
+		Piece::Color color = i < numStrong ? strong : (Piece::Color)!strong;
+		board[strong == Piece::WHITE ? squares[i] : squares[i] ^ 56] = Piece::Ascii[color][pieceType(material, i)];
+	}
+	std::ostringstream fen;
+	for (int rank = NUM_RANKS - 1; rank >= 0; rank--) {
+		int empty = 0;
+		for (int file = 0; file < NUM_FILES; file++) {
+			char c = board[Position::ToInt(file, rank)];
+			if (c == '.') {
+				empty++;
+				continue;
+			}
+			if (empty > 0) fen << empty;
+			empty = 0;
+			fen << c;
+		}
+		if (empty > 0) fen << empty;
+		if (rank > 0) fen << '/';
+	}
+	fen << ((strongToMove == (strong == Piece::WHITE)) ? " w" : " b") << " - - 0 1";
+	return fen.str();
+}
+
+// Checks random positions of a loaded table with Board and MoveList. The score of each position must be the best score of its children,
+//one ply further from the mate. Returns the number of positions that fail.
+unsigned long verify(Bitbase::Material material, int numPositions) {
+	uint64_t seed = 0x9E3779B97F4A7C15ULL + material;
+	unsigned long failures = 0;
+	for (int checked = 0; checked < numPositions;) {
+		// xorshift64 pseudo-random number generator.
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		int index = seed % Bitbase::Size(material);
+		if (tables[material][index] == Bitbase::Illegal) continue;
+		bool strongToMove;
+		position squares[MAX_BITBASE_PIECES];
+		Bitbase::Decode(material, index, strongToMove, squares);
+		std::string fen = toFen(material, strongToMove, squares, checked % 2 == 0 ? Piece::WHITE : Piece::BLACK);
+		checked++;
+		Board board;
+		GameInfo info;
+		int score;
+		if (!Fen::Load(fen, &board, &info) || !Bitbase::Probe(&board, &info, score)) {
+			if (failures++ < 10) std::cerr << "Can't probe " << fen << std::endl;
+			continue;
+		}
+		MoveList moveList;
+		info.updateState(&board, moveList);
+		int expected = moveList.empty() ? (info.inCheck ? -Bitbase::WinScore : 0) : -Bitbase::WinScore - 1;
+		for (MoveList::iterator moveItr = moveList.begin(); moveItr != moveList.end(); moveItr++) {
+			Move move = *moveItr;
+			board.executeMove(move);
+			GameInfo::Irreversible irreversible(&info);
+			info.executeMove(move);
+			// Anything that isn't in a table (a capture or an underpromotion) leaves too little material to win.
+			int childScore = 0;
+			Bitbase::Probe(&board, &info, childScore);
+			board.reverseMove(move);
+			info.reverseMove(irreversible);
+			int moveScore = childScore < 0 ? -childScore - 1 : (childScore > 0 ? -childScore + 1 : 0);
+			expected = std::max(expected, moveScore);
+		}
+		if (score != expected && failures++ < 10) std::cerr << fen << ": bitbase score " << score << ", expected " << expected << std::endl;
+	}
+	return failures;
+}
+
+void usage() {
+	std::cerr << "Usage: bitbase [-o directory] [--threads n] [--verify positions]" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+	Bitboard::Precalculate();
+	Zobrist::Precalculate();
+	std::string directory = "res/bitbases";
+	int verifyPositions = 0;
+	threads = std::max(1u, std::thread::hardware_concurrency());
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "-o" && hasValue) directory = argv[++i];
+		else if (arg == "--threads" && hasValue) threads = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--verify" && hasValue) verifyPositions = std::atoi(argv[++i]);
+		else {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	mkdir(directory.c_str(), 0755);
+	for (int material = 0; material < Bitbase::NUM_MATERIALS; material++) {
+		generate((Bitbase::Material)material);
+		std::string path = Bitbase::Path(directory, (Bitbase::Material)material);
+		std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+		file.write((const char*)&tables[material][0], tables[material].size());
+		file.close();
+		if (file.fail()) {
+			std::cerr << "Can't write " << path << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if (verifyPositions > 0) {
+		Bitbase::Load(directory);
+		unsigned long failures = 0;
+		for (int material = 0; material < Bitbase::NUM_MATERIALS; material++) failures += verify((Bitbase::Material)material, verifyPositions);
+		std::cout << "Verification failures: " << failures << std::endl;
+		if (failures > 0) return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
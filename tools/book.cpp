@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "book.hpp"
+#include "fen.hpp"
+#include "gameinfo.hpp"
+#include "movelist.hpp"
+#include "zobrist.hpp"
+using namespace ChessProject;
+
+// Builds an opening book from games in Portable Game Notation (PGN). Every move of every game is played out on a Board, and checked against
+//the legal moves, up to a maximum number of plies. Each move is weighted by how it scored for the side that played it (2 per win and 1 per
+//draw), so that the engine mostly plays the moves that did best.
+// Usage: book [-o output] [--plies n] [--min-games n] file.pgn...
+
+namespace {
+
+// The results of the games a move was played in, from the point of view of the side that played it.
+struct MoveResults {
+	unsigned long games, wins, draws;
+	MoveResults() : games(0), wins(0), draws(0) { }
+};
+
+// A book move, by position key and encoded move.
+typedef std::pair<hashkey, uint16_t> BookMove;
+
+std::map<BookMove, MoveResults> results;
+int maxPlies = 24;
+
+// Finds the legal move written in standard algebraic notation (e.g. e4, Nbd7, exd8=Q+, O-O). Returns false if there isn't exactly one.
+bool parseSan(std::string san, Board *board, GameInfo *info, Move &move) {
+	// Check, mate and annotation symbols are ignored.
+	while (!san.empty() && std::strchr("+#!?", san[san.size() - 1])) san.erase(san.size() - 1);
+	if (san.empty()) return false;
+	MoveList moveList;
+	info->updateState(board, moveList);
+	bool castling = san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0";
+	bool queenside = castling && san.size() == 5;
+	int type = Piece::PAWN;
+	int promotion = Piece::NONE;
+	position to = -1;
+	std::string disambiguation;
+	if (!castling) {
+		if (std::strchr("KQRBN", san[0])) {
+			type = 0;
+			while (Piece::Ascii[Piece::WHITE][type] != san[0]) type++;
+			san.erase(0, 1);
+		}
+		// Promotions are usually written e8=Q, but sometimes without the equals sign.
+		std::string::size_type equals = san.find('=');
+		if (equals != std::string::npos) san.erase(equals, 1);
+		if (type == Piece::PAWN && !san.empty() && std::strchr("QRBN", san[san.size() - 1])) {
+			promotion = 0;
+			while (Piece::Ascii[Piece::WHITE][promotion] != san[san.size() - 1]) promotion++;
+			san.erase(san.size() - 1);
+		}
+		san.erase(std::remove(san.begin(), san.end(), 'x'), san.end());
+		if (san.size() < 2) return false;
+		to = Position::FromAlgebraic(san.substr(san.size() - 2));
+		if (to < 0) return false;
+		disambiguation = san.substr(0, san.size() - 2);
+	}
+	int matches = 0;
+	for (MoveList::iterator moveItr = moveList.begin(); moveItr != moveList.end(); moveItr++) {
+		bool match;
+		if (castling) {
+			match = moveItr->subject.type == Piece::KING && std::abs(moveItr->subject_to - moveItr->subject_from) == 2 &&
+					queenside == (moveItr->subject_to < moveItr->subject_from);
+		} else {
+			int movePromotion = moveItr->type >= Move::PROMOTION ? moveItr->type - Move::PROMOTION : Piece::NONE;
+			match = moveItr->subject.type == type && moveItr->subject_to == to && movePromotion == promotion;
+			// Each disambiguation character is either the file or the rank of the source square.
+			std::string from = Position::ToAlgebraic(moveItr->subject_from);
+			for (std::string::size_type i = 0; match && i < disambiguation.size(); i++) {
+				match = disambiguation[i] == from[0] || disambiguation[i] == from[1];
+			}
+		}
+		if (match) {
+			move = *moveItr;
+			matches++;
+		}
+	}
+	return matches == 1;
+}
+
+// A game being read. Its moves are kept until the result is known.
+struct Game {
+	Board board;
+	GameInfo info;
+	// Whether the first move has been read, and whether a move failed to parse. The rest of a game with a bad move is ignored.
+	bool started, failed;
+	// The position a game starts from, if it has a FEN tag.
+	std::string fen;
+	std::vector<BookMove> moves;
+	Game() : started(false), failed(false) { }
+};
+
+// Adds the moves of a finished game to the results. The result is "1-0", "0-1", "1/2-1/2" or "*" (unknown).
+void finishGame(Game &game, const std::string &result) {
+	// The first book move is played by the side to move in the starting position, and the sides alternate from there.
+	Piece::Color firstTurn = game.info.turn;
+	if (game.moves.size() % 2 == 1) firstTurn = (Piece::Color)!firstTurn;
+	for (std::size_t i = 0; i < game.moves.size(); i++) {
+		Piece::Color color = (i % 2 == 0) ? firstTurn : (Piece::Color)!firstTurn;
+		MoveResults &moveResults = results[game.moves[i]];
+		moveResults.games++;
+		if (result == "1/2-1/2") moveResults.draws++;
+		else if ((result == "1-0" && color == Piece::WHITE) || (result == "0-1" && color == Piece::BLACK)) moveResults.wins++;
+	}
+	game = Game();
+}
+
+// Handles a token of movetext: a move number, a move, an annotation glyph or a game result. Returns true if the token ends the game.
+bool readToken(Game &game, std::string token, unsigned long gameNumber) {
+	if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") return true;
+	if (token[0] == '$' || game.failed) return false;
+	// Move numbers may be written on their own (12. or 12...) or joined to the move (12.e4). Castling with zeros starts with a digit too.
+	if (token.compare(0, 3, "0-0") != 0) {
+		std::string::size_type start = token.find_first_not_of("0123456789.");
+		if (start == std::string::npos) return false;
+		token.erase(0, start);
+	}
+	if (!game.started) {
+		game.started = true;
+		if (game.fen.empty()) {
+			game.board.init();
+			game.info.init();
+		} else if (!Fen::Load(game.fen, &game.board, &game.info)) {
+			std::cerr << "Game " << gameNumber << ": invalid FEN " << game.fen << std::endl;
+			game.failed = true;
+			return false;
+		}
+	}
+	if ((int)game.moves.size() >= maxPlies) return false;
+	Move move;
+	if (!parseSan(token, &game.board, &game.info, move)) {
+		std::cerr << "Game " << gameNumber << ": illegal or ambiguous move " << token << std::endl;
+		game.failed = true;
+		return false;
+	}
+	game.moves.push_back(BookMove(Book::Key(&game.board, &game.info), Book::EncodeMove(move)));
+	game.board.executeMove(move);
+	game.info.executeMove(move);
+	return false;
+}
+
+// Reads every game in a PGN file. Returns the number of games read.
+unsigned long readPgn(std::istream &input, unsigned long firstGame) {
+	Game game;
+	unsigned long gameNumber = firstGame;
+	// Comments in braces and variations in brackets can span lines.
+	bool inComment = false;
+	int variationDepth = 0;
+	std::string line;
+	while (std::getline(input, line)) {
+		if (!inComment && variationDepth == 0 && !line.empty() && line[0] == '[') {
+			// A tag pair, such as [FEN "..."]. Only the starting position matters.
+			std::string::size_type open = line.find('"'), close = line.rfind('"');
+			if (line.compare(0, 5, "[FEN ") == 0 && open != close) game.fen = line.substr(open + 1, close - open - 1);
+			continue;
+		}
+		if (!line.empty() && line[0] == '%') continue;
+		std::string token;
+		for (std::string::size_type i = 0; i <= line.size(); i++) {
+			char c = i < line.size() ? line[i] : ' ';
+			if (inComment) {
+				if (c == '}') inComment = false;
+				continue;
+			}
+			if (c == '{' || c == '(' || c == ')' || c == ';' || std::isspace((unsigned char)c)) {
+				if (!token.empty() && variationDepth == 0 && readToken(game, token, gameNumber)) {
+					finishGame(game, token);
+					gameNumber++;
+				}
+				token.clear();
+				if (c == '{') inComment = true;
+				else if (c == '(') variationDepth++;
+				else if (c == ')' && variationDepth > 0) variationDepth--;
+				// The rest of the line is a comment.
+				else if (c == ';') break;
+			} else {
+				token += c;
+			}
+		}
+	}
+	return gameNumber - firstGame;
+}
+
+void usage() {
+	std::cerr << "Usage: book [-o output] [--plies n] [--min-games n] file.pgn..." << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+	Bitboard::Precalculate();
+	Zobrist::Precalculate();
+	std::string output = "book.bin";
+	unsigned long minGames = 1;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "-o" && hasValue) output = argv[++i];
+		else if (arg == "--plies" && hasValue) maxPlies = std::atoi(argv[++i]);
+		else if (arg == "--min-games" && hasValue) minGames = std::strtoul(argv[++i], 0, 10);
+		else if (arg[0] != '-') paths.push_back(arg);
+		else {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (paths.empty() || maxPlies < 1) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	unsigned long games = 0;
+	for (std::vector<std::string>::iterator pathItr = paths.begin(); pathItr != paths.end(); pathItr++) {
+		std::ifstream file(pathItr->c_str());
+		if (!file) {
+			std::cerr << "Can't open " << *pathItr << std::endl;
+			return EXIT_FAILURE;
+		}
+		games += readPgn(file, games + 1);
+	}
+	// Weights are scaled down to fit in 16 bits if they need to be. A move that scored anything keeps a weight of at least 1.
+	unsigned long maxWeight = 0;
+	for (std::map<BookMove, MoveResults>::iterator resultItr = results.begin(); resultItr != results.end(); resultItr++) {
+		maxWeight = std::max(maxWeight, resultItr->second.wins * 2 + resultItr->second.draws);
+	}
+	std::vector<Book::Entry> entries;
+	for (std::map<BookMove, MoveResults>::iterator resultItr = results.begin(); resultItr != results.end(); resultItr++) {
+		unsigned long weight = resultItr->second.wins * 2 + resultItr->second.draws;
+		if (resultItr->second.games < minGames || weight == 0) continue;
+		if (maxWeight > 0xFFFF) weight = std::max(weight * 0xFFFF / maxWeight, 1UL);
+		Book::Entry entry;
+		entry.key = resultItr->first.first;
+		entry.move = resultItr->first.second;
+		entry.weight = (uint16_t)weight;
+		entry.learn = 0;
+		entries.push_back(entry);
+	}
+	if (!Book::Write(output, entries)) {
+		std::cerr << "Can't write " << output << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "Games: " << games << std::endl;
+	std::cout << "Book moves: " << entries.size() << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,482 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "fen.hpp"
+#include "gameinfo.hpp"
+#include "movelist.hpp"
+#include "zobrist.hpp"
+using namespace ChessProject;
+
+// Plays a match between two UCI engines, usually two builds or two configurations of chess-uci, to tell whether a change makes the engine
+//stronger. Every worker thread runs its own pair of engine processes and plays one game at a time, so a match keeps every core busy. Each
+//opening is played twice with the colors swapped, so that neither engine gets the better side of an unbalanced opening.
+// The match stops as soon as a sequential probability ratio test (SPRT) accepts either that engine 1 is elo1 stronger than engine 2 (H1) or
+//that it is only elo0 stronger (H0), with false positive and false negative rates alpha and beta, or else after the maximum number of games.
+// Games end with the results of GameInfo::updateState: checkmate, stalemate, insufficient material and the fifty move rule. Threefold
+//repetition and reaching the maximum number of plies are adjudicated as draws. An engine that plays an illegal move, runs out of time or
+//stops responding loses the game, and is restarted for the next one.
+// Alongside the score, the average nodes per second and search depth each engine reported are printed, so that an engine that isn't
+//searching as deep as its clock allows stands out.
+// Usage: match [--engine1 command] [--engine2 command] [--option1 name=value] [--option2 name=value] [--tc seconds+increment] [--games n]
+//[--concurrency n] [--openings file] [--elo0 elo] [--elo1 elo] [--alpha a] [--beta b] [--max-plies n]
+
+namespace {
+
+// Time allowed for an engine to start up or answer isready.
+const long StartTimeout = 10000;
+// Time an engine may go past its clock before it loses on time, for the pipes and the operating system's scheduling.
+const long TimeMargin = 100;
+
+struct EngineConfig {
+	std::string command;
+	// UCI options to set when the engine starts, as name=value.
+	std::vector<std::string> options;
+	std::string name() const {
+		std::string name = command;
+		for (std::vector<std::string>::const_iterator optionItr = options.begin(); optionItr != options.end(); optionItr++) {
+			name += " " + *optionItr;
+		}
+		return name;
+	}
+};
+
+// A UCI engine running in a child process, talking over a pipe to its standard input and another from its standard output.
+class Engine {
+public:
+	Engine() : pid(-1), input(-1), output(-1) { }
+	~Engine() {
+		quit();
+	}
+	// Starts the engine, sets its options and waits for it to be ready. Returns false if it doesn't start or answer in time.
+	bool start(const EngineConfig &config) {
+		int toEngine[2], fromEngine[2];
+		// The pipes are closed on exec, so that engines started by other threads don't hold on to them.
+		if (pipe2(toEngine, O_CLOEXEC) != 0) return false;
+		if (pipe2(fromEngine, O_CLOEXEC) != 0) {
+			::close(toEngine[0]);
+			::close(toEngine[1]);
+			return false;
+		}
+		pid = fork();
+		if (pid == 0) {
+			dup2(toEngine[0], STDIN_FILENO);
+			dup2(fromEngine[1], STDOUT_FILENO);
+			execl("/bin/sh", "sh", "-c", config.command.c_str(), (char*)0);
+			_exit(127);
+		}
+		::close(toEngine[0]);
+		::close(fromEngine[1]);
+		input = toEngine[1];
+		output = fromEngine[0];
+		if (pid < 0) {
+			quit();
+			return false;
+		}
+		send("uci");
+		std::string line;
+		while (line != "uciok") {
+			if (!readLine(line, StartTimeout)) {
+				quit();
+				return false;
+			}
+		}
+		for (std::vector<std::string>::const_iterator optionItr = config.options.begin(); optionItr != config.options.end(); optionItr++) {
+			std::string::size_type equals = optionItr->find('=');
+			std::string value = equals == std::string::npos ? "" : optionItr->substr(equals + 1);
+			send("setoption name " + optionItr->substr(0, equals) + " value " + value);
+		}
+		return waitReady();
+	}
+	// Asks the engine to quit, and kills it if it doesn't.
+	void quit() {
+		if (input >= 0) {
+			send("quit");
+			::close(input);
+			input = -1;
+		}
+		if (pid > 0) {
+			int status;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			while (waitpid(pid, &status, WNOHANG) == 0) {
+				if (std::chrono::steady_clock::now() - start > std::chrono::seconds(1)) {
+					kill(pid, SIGKILL);
+					waitpid(pid, &status, 0);
+					break;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			pid = -1;
+		}
+		if (output >= 0) {
+			::close(output);
+			output = -1;
+		}
+		buffer.clear();
+	}
+	bool isRunning() const {
+		return pid > 0;
+	}
+	void send(const std::string &line) {
+		std::string data = line + "\n";
+		std::string::size_type sent = 0;
+		while (input >= 0 && sent < data.size()) {
+			ssize_t written = write(input, data.data() + sent, data.size() - sent);
+			if (written < 0 && errno == EINTR) continue;
+			// The engine has exited. That is noticed when reading from it.
+			if (written <= 0) return;
+			sent += written;
+		}
+	}
+	// Reads the next line the engine writes. Returns false if the engine exits or doesn't write a whole line within timeout milliseconds.
+	bool readLine(std::string &line, long timeout) {
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+		while (true) {
+			std::string::size_type newline = buffer.find('\n');
+			if (newline != std::string::npos) {
+				line = buffer.substr(0, newline);
+				buffer.erase(0, newline + 1);
+				if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+				return true;
+			}
+			long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+			if (output < 0 || remaining < 0) return false;
+			pollfd descriptor = { output, POLLIN, 0 };
+			int ready = poll(&descriptor, 1, (int)remaining);
+			if (ready < 0 && errno == EINTR) continue;
+			if (ready <= 0) return false;
+			char chunk[4096];
+			ssize_t numRead = read(output, chunk, sizeof(chunk));
+			if (numRead < 0 && errno == EINTR) continue;
+			if (numRead <= 0) return false;
+			buffer.append(chunk, numRead);
+		}
+	}
+	// Sends isready and waits for readyok.
+	bool waitReady() {
+		send("isready");
+		std::string line;
+		while (line != "readyok") {
+			if (!readLine(line, StartTimeout)) return false;
+		}
+		return true;
+	}
+private:
+	pid_t pid;
+	// The engine's standard input and output.
+	int input, output;
+	// Output read from the engine that doesn't make up a whole line yet.
+	std::string buffer;
+	Engine(const Engine&);
+	Engine& operator=(const Engine&);
+};
+
+struct GameResult {
+	// Engine 1's score: 1 for a win, 0.5 for a draw and 0 for a loss.
+	double score;
+	std::string reason;
+	int plies;
+	// The nodes searched and time spent searching (in milliseconds) that each engine reported.
+	unsigned long nodes[2];
+	long searchTime[2];
+	// The sum of the last depth each engine reported for its moves, and the number of moves it searched. A low average depth shows that
+	//an engine isn't using its time.
+	long depths[2];
+	int searches[2];
+	GameResult() : score(0.5), plies(0) {
+		nodes[0] = nodes[1] = 0;
+		searchTime[0] = searchTime[1] = 0;
+		depths[0] = depths[1] = 0;
+		searches[0] = searches[1] = 0;
+	}
+};
+
+EngineConfig configs[2];
+std::vector<std::string> openings;
+long baseTime = 10000, increment = 100;
+unsigned long maxGames = 10000;
+int maxPlies = 400;
+double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+// The next game to start, and whether the match is over. Games already being played are finished and counted.
+std::atomic<unsigned long> nextGame(0);
+std::atomic<bool> stopped(false);
+// The results so far, from engine 1's point of view.
+unsigned long wins = 0, losses = 0, draws = 0;
+unsigned long totalNodes[2] = { 0, 0 };
+long totalSearchTime[2] = { 0, 0 };
+long totalDepths[2] = { 0, 0 };
+long totalSearches[2] = { 0, 0 };
+std::string verdict;
+std::mutex resultsMutex;
+
+// The key of a position for detecting repetitions. It leaves out the fifty move rule counter, which is part of the game info's hash.
+hashkey repetitionKey(const Board *board, const GameInfo *info) {
+	return board->getHash() ^ info->hash ^ Zobrist::FiftyMoveKey(info->fiftyMoveRuleCounter);
+}
+
+// Sets the result of a game won by engine side (0 for engine 1) and returns it.
+GameResult &win(GameResult &result, int side, const std::string &reason) {
+	result.score = side == 0 ? 1 : 0;
+	result.reason = reason;
+	return result;
+}
+
+GameResult &draw(GameResult &result, const std::string &reason) {
+	result.score = 0.5;
+	result.reason = reason;
+	return result;
+}
+
+// Plays a game from an opening. engines[0] is engine 1. An engine that loses by not answering is shut down, to be restarted for the next
+//game.
+GameResult playGame(Engine *engines, const std::string &opening, bool engine1White) {
+	GameResult result;
+	Board board;
+	GameInfo info;
+	Fen::Load(opening, &board, &info);
+	for (int side = 0; side < 2; side++) {
+		engines[side].send("ucinewgame");
+		if (!engines[side].waitReady()) {
+			engines[side].quit();
+			return win(result, !side, "engine not responding");
+		}
+	}
+	long clock[NUM_COLORS] = { baseTime, baseTime };
+	std::map<hashkey, int> repetitions;
+	std::string moves;
+	while (true) {
+		MoveList moveList;
+		GameInfo::State state = info.updateState(&board, moveList);
+		// The engine to move, by index into engines.
+		int side = (info.turn == Piece::WHITE) == engine1White ? 0 : 1;
+		if (state == GameInfo::CHECKMATE) return win(result, !side, "checkmate");
+		if (state == GameInfo::STALEMATE) return draw(result, board.insufficientMaterial() ? "insufficient material" : "stalemate");
+		if (state == GameInfo::FIFTY_MOVE_RULE) return draw(result, "fifty move rule");
+		if (++repetitions[repetitionKey(&board, &info)] >= 3) return draw(result, "threefold repetition");
+		if (result.plies >= maxPlies) return draw(result, "maximum plies");
+		Engine &engine = engines[side];
+		engine.send("position fen " + opening + (moves.empty() ? "" : " moves" + moves));
+		std::ostringstream go;
+		go << "go wtime " << clock[Piece::WHITE] << " btime " << clock[Piece::BLACK] << " winc " << increment << " binc " << increment;
+		engine.send(go.str());
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::string line, bestMove;
+		unsigned long nodes = 0;
+		long searchTime = 0;
+		int depth = 0;
+		while (bestMove.empty() && engine.readLine(line, std::max(clock[info.turn] + TimeMargin, 1L))) {
+			std::istringstream tokens(line);
+			std::string token;
+			tokens >> token;
+			if (token == "bestmove") {
+				tokens >> bestMove;
+			} else if (token == "info") {
+				while (tokens >> token) {
+					if (token == "depth") tokens >> depth;
+					else if (token == "nodes") tokens >> nodes;
+					else if (token == "time") tokens >> searchTime;
+				}
+			}
+		}
+		clock[info.turn] -= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		result.nodes[side] += nodes;
+		result.searchTime[side] += searchTime;
+		result.depths[side] += depth;
+		result.searches[side]++;
+		if (bestMove.empty() || clock[info.turn] < -TimeMargin) {
+			// The engine may still be searching.
+			engine.quit();
+			return win(result, !side, bestMove.empty() && clock[info.turn] >= -TimeMargin ? "engine not responding" : "time forfeit");
+		}
+		clock[info.turn] += increment;
+		MoveList::iterator moveItr = moveList.begin();
+		while (moveItr != moveList.end() && moveItr->toAlgebraic() != bestMove) moveItr++;
+		if (moveItr == moveList.end()) return win(result, !side, "illegal move " + bestMove);
+		board.executeMove(*moveItr);
+		info.executeMove(*moveItr);
+		moves += " " + bestMove;
+		result.plies++;
+	}
+}
+
+// Returns the Elo difference that gives a score (between 0 and 1).
+double elo(double score) {
+	score = std::min(std::max(score, 1e-6), 1 - 1e-6);
+	return 400 * std::log10(score / (1 - score));
+}
+
+double expectedScore(double elo) {
+	return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+// Returns the mean score of the results and its variance per game.
+void scoreStatistics(double &score, double &variance) {
+	double games = wins + losses + draws;
+	score = games > 0 ? (wins + draws / 2.0) / games : 0.5;
+	variance = games > 0 ? (wins * std::pow(1 - score, 2) + draws * std::pow(0.5 - score, 2) + losses * std::pow(score, 2)) / games : 0;
+}
+
+// Returns the log likelihood ratio of H1 (engine 1 is elo1 stronger) to H0 (it is elo0 stronger), approximating the score of a game by a
+//normal distribution with the variance of the results so far. The variance is estimated with half a game added to each kind of result, so
+//that it isn't zero after a run of one result (such as an engine that loses every game).
+double logLikelihoodRatio() {
+	double score, variance;
+	scoreStatistics(score, variance);
+	variance = ((wins + 0.5) * std::pow(1 - score, 2) + (draws + 0.5) * std::pow(0.5 - score, 2) + (losses + 0.5) * std::pow(score, 2)) /
+			   (wins + losses + draws + 1.5);
+	double score0 = expectedScore(elo0), score1 = expectedScore(elo1);
+	return (wins + losses + draws) * (score1 - score0) * (2 * score - score0 - score1) / (2 * variance);
+}
+
+void recordGame(unsigned long game, bool engine1White, const GameResult &result) {
+	std::lock_guard<std::mutex> lock(resultsMutex);
+	if (result.score == 1) wins++;
+	else if (result.score == 0) losses++;
+	else draws++;
+	for (int side = 0; side < 2; side++) {
+		totalNodes[side] += result.nodes[side];
+		totalSearchTime[side] += result.searchTime[side];
+		totalDepths[side] += result.depths[side];
+		totalSearches[side] += result.searches[side];
+	}
+	double whiteScore = engine1White ? result.score : 1 - result.score;
+	std::cout << "Game " << game + 1 << ": " << configs[engine1White ? 0 : 1].name() << " vs " << configs[engine1White ? 1 : 0].name() << " "
+			  << (whiteScore == 1 ? "1-0" : (whiteScore == 0 ? "0-1" : "1/2-1/2")) << " {" << result.reason << "} in " << result.plies
+			  << " plies. Score " << wins << "-" << losses << "-" << draws << std::endl;
+	double ratio = logLikelihoodRatio();
+	if (verdict.empty() && ratio >= std::log((1 - beta) / alpha)) verdict = "H1 accepted";
+	else if (verdict.empty() && ratio <= std::log(beta / (1 - alpha))) verdict = "H0 accepted";
+	if (!verdict.empty()) stopped = true;
+}
+
+void work(int worker) {
+	Engine engines[2];
+	while (!stopped) {
+		unsigned long game = nextGame++;
+		if (game >= maxGames) return;
+		for (int side = 0; side < 2; side++) {
+			if (engines[side].isRunning() || engines[side].start(configs[side])) continue;
+			std::lock_guard<std::mutex> lock(resultsMutex);
+			std::cerr << "Worker " << worker << " can't start " << configs[side].command << std::endl;
+			stopped = true;
+			return;
+		}
+		// Consecutive games play the same opening with the colors swapped.
+		recordGame(game, game % 2 == 0, playGame(engines, openings[(game / 2) % openings.size()], game % 2 == 0));
+	}
+}
+
+// Reads the opening positions from a file of FEN or EPD lines. Only the first four fields of each line are used. Returns false if the file
+//can't be read or holds no valid position.
+bool readOpenings(const std::string &path) {
+	std::ifstream file(path.c_str());
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		std::string field, position;
+		for (int i = 0; i < 4 && fields >> field; i++) position += (i > 0 ? " " : "") + field;
+		Board board;
+		GameInfo info;
+		if (Fen::Load(position, &board, &info)) openings.push_back(Fen::Save(&board, &info));
+		else if (position.find_first_not_of(" \t\r") != std::string::npos) std::cerr << "Invalid opening: " << line << std::endl;
+	}
+	return !openings.empty();
+}
+
+void usage() {
+	std::cerr << "Usage: match [--engine1 command] [--engine2 command] [--option1 name=value] [--option2 name=value] [--tc seconds+increment]"
+			  << std::endl << "             [--games n] [--concurrency n] [--openings file] [--elo0 elo] [--elo1 elo] [--alpha a] [--beta b]"
+			  << std::endl << "             [--max-plies n]" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+	Bitboard::Precalculate();
+	Zobrist::Precalculate();
+	// Writing to an engine that has exited must fail rather than end the match.
+	std::signal(SIGPIPE, SIG_IGN);
+	configs[0].command = configs[1].command = "./chess-uci";
+	int concurrency = std::max(1u, std::thread::hardware_concurrency());
+	std::string openingsPath;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--engine1" && hasValue) configs[0].command = argv[++i];
+		else if (arg == "--engine2" && hasValue) configs[1].command = argv[++i];
+		else if (arg == "--option1" && hasValue) configs[0].options.push_back(argv[++i]);
+		else if (arg == "--option2" && hasValue) configs[1].options.push_back(argv[++i]);
+		else if (arg == "--tc" && hasValue) {
+			// Seconds for the game, with an optional increment in seconds per move.
+			std::string tc = argv[++i];
+			std::string::size_type plus = tc.find('+');
+			baseTime = (long)(std::atof(tc.substr(0, plus).c_str()) * 1000);
+			increment = plus == std::string::npos ? 0 : (long)(std::atof(tc.substr(plus + 1).c_str()) * 1000);
+		}
+		else if (arg == "--games" && hasValue) maxGames = std::strtoul(argv[++i], 0, 10);
+		else if (arg == "--concurrency" && hasValue) concurrency = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--openings" && hasValue) openingsPath = argv[++i];
+		else if (arg == "--elo0" && hasValue) elo0 = std::atof(argv[++i]);
+		else if (arg == "--elo1" && hasValue) elo1 = std::atof(argv[++i]);
+		else if (arg == "--alpha" && hasValue) alpha = std::atof(argv[++i]);
+		else if (arg == "--beta" && hasValue) beta = std::atof(argv[++i]);
+		else if (arg == "--max-plies" && hasValue) maxPlies = std::atoi(argv[++i]);
+		else {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (baseTime <= 0 || elo1 <= elo0 || alpha <= 0 || alpha >= 1 || beta <= 0 || beta >= 1) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (openingsPath.empty()) {
+		openings.push_back(Fen::InitialPosition);
+	} else if (!readOpenings(openingsPath)) {
+		std::cerr << "No openings in " << openingsPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int i = 0; i < concurrency; i++) workers.push_back(std::thread(work, i));
+	for (std::vector<std::thread>::iterator workerItr = workers.begin(); workerItr != workers.end(); workerItr++) workerItr->join();
+	double hours = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 3600;
+	unsigned long games = wins + losses + draws;
+	double score, variance;
+	scoreStatistics(score, variance);
+	// A 95% confidence interval of the score, as Elo.
+	double margin = games > 0 ? 1.96 * std::sqrt(variance / games) : 0;
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "Engine 1: " << configs[0].name() << std::endl;
+	std::cout << "Engine 2: " << configs[1].name() << std::endl;
+	std::cout << "Games: " << games << " (" << wins << " wins, " << losses << " losses, " << draws << " draws for engine 1)" << std::endl;
+	std::cout << "Score: " << score * 100 << "%" << std::endl;
+	std::cout << "Elo: " << elo(score) << " +/- " << (elo(score + margin) - elo(score - margin)) / 2 << std::endl;
+	std::cout << std::setprecision(2) << "SPRT (elo0 " << elo0 << ", elo1 " << elo1 << "): LLR " << logLikelihoodRatio() << " ["
+			  << std::log(beta / (1 - alpha)) << ", " << std::log((1 - beta) / alpha) << "], " << (verdict.empty() ? "inconclusive" : verdict)
+			  << std::endl;
+	std::cout << std::setprecision(0) << "Games per hour: " << (hours > 0 ? games / hours : 0) << std::endl;
+	for (int side = 0; side < 2; side++) {
+		std::cout << std::setprecision(0) << "Engine " << side + 1 << " average NPS: " << totalNodes[side] * 1000.0 / std::max(totalSearchTime[side], 1L)
+				  << std::setprecision(1) << ", average depth: " << (double)totalDepths[side] / std::max(totalSearches[side], 1L) << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "fen.hpp"
+#include "gameinfo.hpp"
+#include "movelist.hpp"
+#include "zobrist.hpp"
+using namespace ChessProject;
+
+// Perft walks the tree of legal moves to a fixed depth and counts the leaf nodes. The counts for well known positions are published, so
+//comparing against them tests the move generator, and timing them measures its throughput.
+// Usage: perft [-d depth] [-f fen] [--divide] [--hash megabytes] [--threads n] [--verify]
+
+namespace {
+
+// Previously counted subtrees, indexed by position hash. Shared between threads without locking in the same way as the transposition
+//table: each slot stores the hash XORed with the data, so a slot that is torn by two simultaneous writes reads back as a miss.
+class PerftTable {
+public:
+	PerftTable(std::size_t sizeMB) {
+		std::size_t numSlots = 1;
+		while (numSlots * 2 * sizeof(Slot) <= sizeMB * 1024 * 1024) numSlots *= 2;
+		std::vector<Slot> newSlots(numSlots);
+		slots.swap(newSlots);
+		mask = numSlots - 1;
+	}
+	// The data word holds the depth in the bottom 8 bits and the node count in the rest.
+	bool probe(hashkey key, int depth, uint64_t &nodes) const {
+		const Slot &slot = slots[key & mask];
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		if ((slot.check.load(std::memory_order_relaxed) ^ data) != key || (int)(data & 255) != depth) return false;
+		nodes = data >> 8;
+		return true;
+	}
+	void store(hashkey key, int depth, uint64_t nodes) {
+		Slot &slot = slots[key & mask];
+		uint64_t data = (nodes << 8) | depth;
+		slot.check.store(key ^ data, std::memory_order_relaxed);
+		slot.data.store(data, std::memory_order_relaxed);
+	}
+private:
+	struct Slot {
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;
+		Slot() : check(0), data(0) { }
+	};
+	std::vector<Slot> slots;
+	std::size_t mask;
+};
+
+PerftTable *table = 0;
+bool verify = false;
+std::atomic<unsigned long> mismatches(0);
+
+// Generates legal moves. Unlike GameInfo::updateState, this doesn't stop at drawn positions, as published perft counts ignore draws. The
+//moves are only counted, so they are left unordered.
+void generateLegal(Board *board, GameInfo *info, MoveList &moveList) {
+	moveList.clear();
+	if (MoveList::InCheck(info->turn, board)) info->inCheck = true;
+	moveList.generateLegal(info->turn, board, info, ~(bitboard64)0, true, true);
+}
+
+// Returns true if two move lists hold the same moves, in any order.
+bool sameMoves(MoveList &moves, MoveList &others) {
+	bool match = moves.size() == others.size();
+	for (MoveList::iterator moveItr = moves.begin(); match && moveItr != moves.end(); moveItr++) {
+		MoveList::iterator other = others.getMove(moveItr->subject_from, moveItr->subject_to, moveItr->type);
+		match = other != others.end() && other->object_from == moveItr->object_from && other->object_to == moveItr->object_to;
+	}
+	return match;
+}
+
+// Checks that the bitboard and mailbox generators agree, with and without onlyInteresting, and that the legal generator agrees with
+//pruning the pseudo-legal moves.
+void verifyGenerators(Board *board, GameInfo *info) {
+	bool inCheck = MoveList::InCheck(info->turn, board);
+	if (inCheck) info->inCheck = true;
+	MoveList legalMoves, prunedMoves;
+	legalMoves.generateLegal(info->turn, board, info);
+	prunedMoves.generate(info->turn, board, info);
+	prunedMoves.prune((Piece::Color)!info->turn, board);
+	if (!sameMoves(legalMoves, prunedMoves) && mismatches++ == 0) {
+		std::cerr << "Legal move generator disagrees in " << Fen::Save(board, info) << std::endl;
+	}
+	// Outside of check, the legal captures are the pruned pseudo-legal captures.
+	if (!inCheck) {
+		legalMoves.clear();
+		prunedMoves.clear();
+		legalMoves.generateLegal(info->turn, board, info, true);
+		prunedMoves.generate(info->turn, board, info, true);
+		prunedMoves.prune((Piece::Color)!info->turn, board);
+		if (!sameMoves(legalMoves, prunedMoves) && mismatches++ == 0) {
+			std::cerr << "Legal move generator disagrees on captures in " << Fen::Save(board, info) << std::endl;
+		}
+	}
+	for (int onlyInteresting = 0; onlyInteresting < 2; onlyInteresting++) {
+		MoveList bitboardMoves, mailboxMoves;
+		bitboardMoves.generate(info->turn, board, info, onlyInteresting);
+		mailboxMoves.generateMailbox(info->turn, board, info, onlyInteresting);
+		if (!sameMoves(bitboardMoves, mailboxMoves) && mismatches++ == 0) {
+			std::cerr << "Move generators disagree" << (onlyInteresting ? " on captures" : "") << " in " << Fen::Save(board, info) << std::endl;
+		}
+	}
+}
+
+uint64_t perft(Board *board, GameInfo *info, int depth, std::vector<MoveList> &stack) {
+	if (verify) verifyGenerators(board, info);
+	hashkey hash = board->getHash() ^ info->hash;
+	uint64_t nodes = 0;
+	// A position counted before needs no moves generated at all.
+	if (depth > 1 && table && table->probe(hash, depth, nodes)) return nodes;
+	MoveList &moveList = stack[depth];
+	generateLegal(board, info, moveList);
+	if (depth == 1) return moveList.size();
+	for (MoveList::iterator moveItr = moveList.begin(); moveItr != moveList.end(); moveItr++) {
+		Move move = *moveItr;
+		board->executeMove(move);
+		GameInfo::Irreversible irreversible(info);
+		info->executeMove(move);
+		nodes += perft(board, info, depth - 1, stack);
+		board->reverseMove(move);
+		info->reverseMove(irreversible);
+	}
+	if (table) table->store(hash, depth, nodes);
+	return nodes;
+}
+
+// Root moves are handed out to threads one at a time. Every thread has its own copy of the position, and generates the same root move list
+//on it so that a move index refers to the same move on every copy.
+void searchRootMoves(const Board *rootBoard, const GameInfo *rootInfo, int depth, std::atomic<int> *nextMove, std::vector<uint64_t> *counts) {
+	Board board(*rootBoard);
+	GameInfo info(*rootInfo);
+	std::vector<MoveList> stack(depth + 1);
+	MoveList rootMoves;
+	generateLegal(&board, &info, rootMoves);
+	for (int i = (*nextMove)++; i < rootMoves.size(); i = (*nextMove)++) {
+		Move move = rootMoves.begin()[i];
+		board.executeMove(move);
+		GameInfo::Irreversible irreversible(&info);
+		info.executeMove(move);
+		(*counts)[i] = depth > 1 ? perft(&board, &info, depth - 1, stack) : 1;
+		board.reverseMove(move);
+		info.reverseMove(irreversible);
+	}
+}
+
+void usage() {
+	std::cerr << "Usage: perft [-d depth] [-f fen] [--divide] [--hash megabytes] [--threads n] [--verify]" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+	Bitboard::Precalculate();
+	Zobrist::Precalculate();
+	int depth = 5;
+	std::string fen = Fen::InitialPosition;
+	bool divide = false;
+	int hashMB = 0;
+	int threads = 1;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "-d" && hasValue) depth = std::atoi(argv[++i]);
+		else if (arg == "-f" && hasValue) fen = argv[++i];
+		else if (arg == "--divide") divide = true;
+		else if (arg == "--hash" && hasValue) hashMB = std::atoi(argv[++i]);
+		else if (arg == "--threads" && hasValue) threads = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--verify") verify = true;
+		else {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	Board board;
+	GameInfo info;
+	if (depth < 1 || !Fen::Load(fen, &board, &info)) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (hashMB > 0) table = new PerftTable(hashMB);
+	MoveList rootMoves;
+	generateLegal(&board, &info, rootMoves);
+	std::vector<uint64_t> counts(rootMoves.size(), 0);
+	std::atomic<int> nextMove(0);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; i++) {
+		workers.push_back(std::thread(searchRootMoves, &board, &info, depth, &nextMove, &counts));
+	}
+	for (std::vector<std::thread>::iterator workerItr = workers.begin(); workerItr != workers.end(); workerItr++) {
+		workerItr->join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	uint64_t nodes = 0;
+	for (int i = 0; i < rootMoves.size(); i++) {
+		if (divide) std::cout << rootMoves.begin()[i].toAlgebraic() << ": " << counts[i] << std::endl;
+		nodes += counts[i];
+	}
+	if (divide) std::cout << std::endl;
+	std::cout << "Nodes: " << nodes << std::endl;
+	std::cout << "Time: " << seconds << " s" << std::endl;
+	std::cout << "NPS: " << (uint64_t)(nodes / std::max(seconds, 1e-9)) << std::endl;
+	delete table;
+	if (verify) {
+		std::cout << "Generator mismatches: " << mismatches << std::endl;
+		if (mismatches > 0) return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "evalparams.hpp"
+#include "fen.hpp"
+#include "gameinfo.hpp"
+#include "minimax.hpp"
+#include "zobrist.hpp"
+using namespace ChessProject;
+
+// Tunes the evaluation weights to a set of positions labelled with the results of the games they were taken from, by the Texel method:
+//the evaluation of each position, passed through a sigmoid, is taken as a prediction of the result, and gradient descent (Adam) minimises
+//the mean squared error of the predictions.
+// The evaluation is a weighted sum, so each position only has to be set up once, to find which weights its evaluation uses and how many
+//times (the coefficients, relative to white). The whole training set is then held in a few flat arrays: every position's result, and the
+//parameter indices and coefficients of every position's terms, one after another. Each epoch, every thread evaluates its share of the
+//positions a batch at a time, first every evaluation of the batch, then every prediction and error, then the gradient. Each step is a
+//short loop over contiguous memory that the compiler can vectorise, and no board is touched.
+// Each line of the input is a FEN or EPD position followed by the result of its game, either as 1-0, 0-1 or 1/2-1/2 (which may be
+//quoted, as in an EPD c9 operation) or as 1.0, 0.5 or 0.0 (which may be in brackets). The positions should be quiet, as they are
+//evaluated as they are, without a search.
+// Usage: tune [-o output] [--weights file] [--epochs n] [--rate r] [-k scale] [--threads n] file...
+// The tuned weights are written as a file that EvalParams::Load reads (the EvalFile UCI option), every report and at the end.
+
+namespace {
+
+// The training set, as a structure of arrays. The terms of position i are terms offsets[i] to offsets[i + 1] - 1.
+struct TrainingSet {
+	// The result of each position's game for white: 1 for a win, 0.5 for a draw and 0 for a loss.
+	std::vector<float> results;
+	std::vector<uint32_t> offsets;
+	std::vector<uint16_t> params;
+	std::vector<float> coefficients;
+	TrainingSet() : offsets(1, 0) { }
+	std::size_t size() const {
+		return results.size();
+	}
+	void append(const TrainingSet &other) {
+		uint32_t base = offsets.back();
+		results.insert(results.end(), other.results.begin(), other.results.end());
+		for (std::size_t i = 1; i < other.offsets.size(); i++) offsets.push_back(base + other.offsets[i]);
+		params.insert(params.end(), other.params.begin(), other.params.end());
+		coefficients.insert(coefficients.end(), other.coefficients.begin(), other.coefficients.end());
+	}
+};
+
+// Lines are read and set up this many at a time, so that the text of a large file is never held in memory all at once.
+const std::size_t LinesPerChunk = 1 << 18;
+// Positions evaluated together by a thread.
+const int BatchSize = 1024;
+const int DefaultEpochs = 1000;
+const int ReportInterval = 50;
+// Adam's decay rates for its averages of the gradient and its square.
+const double Beta1 = 0.9;
+const double Beta2 = 0.999;
+const double Epsilon = 1e-8;
+
+TrainingSet positions;
+int threads = 1;
+// The sigmoid maps an evaluation of scale * 400 centipawns to odds of 10 to 1.
+double scale = 0;
+// The weights being tuned, as floating point numbers.
+std::vector<float> weights;
+
+// Adds the terms of a position's evaluation to coefficients (indexed by parameter), relative to white. This follows Minimax::Eval, which
+//loading checks it against.
+void addTerms(Board *board, std::vector<float> &coefficients) {
+	int phase = std::min(board->getPhase(), (int)Piece::MaxPhase);
+	// The shares of the middlegame and endgame king tables in the evaluation. Without tapering, the king has no bonus in the endgame.
+	float middleGame = Board::TaperedEval ? (float)phase / Piece::MaxPhase : (board->isEndGame() ? 0 : 1);
+	float endGame = Board::TaperedEval ? 1 - middleGame : 0;
+	for (int color = 0; color < NUM_COLORS; color++) {
+		int sign = color == Piece::WHITE ? 1 : -1;
+		for (int type = 0; type < NUM_PIECE_TYPES; type++) {
+			bitboard64 pieces = board->getPieces((Piece::Color)color, (Piece::Type)type);
+			coefficients[EvalParams::MATERIAL_WORTH + type] += sign * __builtin_popcountll(pieces);
+			while (pieces) {
+				position pos = Bitboard::PopFirst(pieces);
+				// Black's pieces use the tables upside down.
+				if (color == Piece::BLACK) pos ^= 56;
+				if (type == Piece::KING) {
+					coefficients[EvalParams::BONUS_TABLE + type * BOARDSIZE + pos] += sign * middleGame;
+					coefficients[EvalParams::ENDGAME_KING_TABLE + pos] += sign * endGame;
+				} else {
+					coefficients[EvalParams::BONUS_TABLE + type * BOARDSIZE + pos] += sign;
+				}
+			}
+		}
+		bitboard64 rooks = board->getPieces((Piece::Color)color, Piece::ROOK);
+		bitboard64 pawns = board->getPieces((Piece::Color)color, Piece::PAWN);
+		while (rooks) {
+			// A rook is on an open or semi-open file if none of its own pawns are on the file.
+			bitboard64 file = 0x0101010101010101ULL << Position::File(Bitboard::PopFirst(rooks));
+			if (!(file & pawns)) coefficients[EvalParams::ROOK_ON_OPEN_FILE] += sign;
+		}
+		bitboard64 bishops = board->getPieces((Piece::Color)color, Piece::BISHOP);
+		if (__builtin_popcountll(bishops) > 1) coefficients[EvalParams::BOTH_BISHOPS_BONUS] += sign;
+		bitboard64 center = board->getAttacks((Piece::Color)color) & Minimax::CenterSquares;
+		coefficients[EvalParams::CENTER_CONTROL_BONUS] += sign * __builtin_popcountll(center);
+	}
+	Board::PawnFeatures features;
+	board->countPawnFeatures(features);
+	coefficients[board->isEndGame() ? EvalParams::ENDGAME_PASSED_PAWN_BONUS : EvalParams::PASSED_PAWN_BONUS] += features.passed;
+	coefficients[EvalParams::ISOLATED_PAWN_PENALTY] += features.isolated;
+	coefficients[EvalParams::DOUBLED_PAWN_PENALTY] += features.doubled;
+	coefficients[EvalParams::BACKWARD_PAWN_PENALTY] += features.backward;
+}
+
+// Finds the result of a line's game in the text after its position. Returns false if there isn't one.
+bool parseResult(std::istream &fields, float &result) {
+	std::string field;
+	while (fields >> field) {
+		std::string::size_type first = field.find_first_not_of("\"[");
+		std::string::size_type last = field.find_last_not_of("\"];");
+		if (first == std::string::npos || last < first) continue;
+		field = field.substr(first, last - first + 1);
+		if (field == "1-0" || field == "1.0") result = 1;
+		else if (field == "0-1" || field == "0.0") result = 0;
+		else if (field == "1/2-1/2" || field == "0.5") result = 0.5;
+		else continue;
+		return true;
+	}
+	return false;
+}
+
+// Sets up lines of the input and adds their positions to set. Counts the lines that can't be used, and the positions whose terms don't
+//add up to Minimax::Eval (allowing for rounding).
+void loadLines(const std::vector<std::string> *lines, std::size_t begin, std::size_t end, TrainingSet *set, unsigned long *skipped,
+			   unsigned long *mismatches) {
+	Board board;
+	GameInfo info;
+	std::vector<float> coefficients(EvalParams::NUM_PARAMS);
+	for (std::size_t i = begin; i < end; i++) {
+		std::istringstream fields((*lines)[i]);
+		std::string field, fen;
+		for (int j = 0; j < 4 && fields >> field; j++) fen += (j > 0 ? " " : "") + field;
+		float result;
+		// Positions drawn by insufficient material are scored as draws without being evaluated.
+		if (!parseResult(fields, result) || !Fen::Load(fen, &board, &info) || (board.isEndGame() && board.insufficientMaterial())) {
+			(*skipped)++;
+			continue;
+		}
+		std::fill(coefficients.begin(), coefficients.end(), 0);
+		addTerms(&board, coefficients);
+		double eval = 0;
+		for (int param = 0; param < EvalParams::NUM_PARAMS; param++) {
+			if (coefficients[param] == 0) continue;
+			eval += coefficients[param] * EvalParams::Weights[param];
+			set->params.push_back(param);
+			set->coefficients.push_back(coefficients[param]);
+		}
+		int expected = Minimax::Eval(&board, &info) * (info.turn == Piece::WHITE ? 1 : -1);
+		if (std::abs(eval - expected) > 1) (*mismatches)++;
+		set->results.push_back(result);
+		set->offsets.push_back(set->params.size());
+	}
+}
+
+// Reads a file into the training set, setting up the lines of each chunk in parallel. Returns false if the file can't be read.
+bool loadFile(const std::string &path, unsigned long &skipped, unsigned long &mismatches) {
+	std::ifstream file(path.c_str());
+	if (!file) return false;
+	std::vector<std::string> lines;
+	while (file) {
+		lines.clear();
+		std::string line;
+		while (lines.size() < LinesPerChunk && std::getline(file, line)) {
+			if (line.find_first_not_of(" \t\r") != std::string::npos) lines.push_back(line);
+		}
+		std::vector<TrainingSet> sets(threads);
+		std::vector<unsigned long> threadSkipped(threads, 0), threadMismatches(threads, 0);
+		std::vector<std::thread> workers;
+		for (int i = 0; i < threads; i++) {
+			workers.push_back(std::thread(loadLines, &lines, lines.size() * i / threads, lines.size() * (i + 1) / threads, &sets[i],
+										  &threadSkipped[i], &threadMismatches[i]));
+		}
+		for (int i = 0; i < threads; i++) {
+			workers[i].join();
+			positions.append(sets[i]);
+			skipped += threadSkipped[i];
+			mismatches += threadMismatches[i];
+		}
+	}
+	return true;
+}
+
+// Works through positions begin to end - 1 in batches. Adds their squared errors to error, and if gradient isn't null, adds the gradient
+//of the squared errors with respect to the weights to it.
+void evaluateRange(std::size_t begin, std::size_t end, double *error, std::vector<double> *gradient) {
+	const float *results = &positions.results[0];
+	const uint32_t *offsets = &positions.offsets[0];
+	const uint16_t *params = &positions.params[0];
+	const float *coefficients = &positions.coefficients[0];
+	const float *weightData = &weights[0];
+	float evals[BatchSize], derivatives[BatchSize];
+	// The prediction is 1 / (1 + 10^(-scale * eval / 400)), written with exp.
+	const float factor = (float)(scale * std::log(10.0) / 400);
+	double sum = 0;
+	for (std::size_t batch = begin; batch < end; batch += BatchSize) {
+		int batchSize = (int)std::min((std::size_t)BatchSize, end - batch);
+		for (int i = 0; i < batchSize; i++) {
+			float eval = 0;
+			for (uint32_t term = offsets[batch + i]; term < offsets[batch + i + 1]; term++) eval += coefficients[term] * weightData[params[term]];
+			evals[i] = eval;
+		}
+		for (int i = 0; i < batchSize; i++) {
+			float prediction = 1 / (1 + std::exp(-factor * evals[i]));
+			float difference = prediction - results[batch + i];
+			sum += difference * difference;
+			// The derivative of the squared error with respect to the evaluation.
+			derivatives[i] = 2 * difference * prediction * (1 - prediction) * factor;
+		}
+		if (!gradient) continue;
+		for (int i = 0; i < batchSize; i++) {
+			for (uint32_t term = offsets[batch + i]; term < offsets[batch + i + 1]; term++) {
+				(*gradient)[params[term]] += derivatives[i] * coefficients[term];
+			}
+		}
+	}
+	*error = sum;
+}
+
+// Returns the mean squared error of the predictions. If gradient isn't null, sets it to the gradient of the error.
+double evaluate(std::vector<double> *gradient) {
+	std::vector<double> errors(threads, 0);
+	std::vector<std::vector<double> > gradients(threads, std::vector<double>(gradient ? EvalParams::NUM_PARAMS : 0, 0));
+	std::vector<std::thread> workers;
+	std::size_t size = positions.size();
+	for (int i = 0; i < threads; i++) {
+		workers.push_back(std::thread(evaluateRange, size * i / threads, size * (i + 1) / threads, &errors[i], gradient ? &gradients[i] : 0));
+	}
+	double error = 0;
+	if (gradient) gradient->assign(EvalParams::NUM_PARAMS, 0);
+	for (int i = 0; i < threads; i++) {
+		workers[i].join();
+		error += errors[i];
+		for (int param = 0; gradient && param < EvalParams::NUM_PARAMS; param++) (*gradient)[param] += gradients[i][param] / size;
+	}
+	return error / size;
+}
+
+// Finds the scale that best fits the untuned weights, by golden section search. The weights are then tuned with the scale fixed, so
+//that they stay in centipawns.
+void fitScale() {
+	double low = 0, high = 5;
+	const double Ratio = (std::sqrt(5.0) - 1) / 2;
+	while (high - low > 1e-4) {
+		double left = high - Ratio * (high - low), right = low + Ratio * (high - low);
+		scale = left;
+		double leftError = evaluate(0);
+		scale = right;
+		double rightError = evaluate(0);
+		if (leftError < rightError) high = right;
+		else low = left;
+	}
+	scale = (low + high) / 2;
+}
+
+// Copies the tuned weights, rounded, into the engine's weights and writes them to a file.
+bool saveWeights(const std::string &path) {
+	for (int param = 0; param < EvalParams::NUM_PARAMS; param++) EvalParams::Weights[param] = (int)std::lround(weights[param]);
+	return EvalParams::Save(path);
+}
+
+void usage() {
+	std::cerr << "Usage: tune [-o output] [--weights file] [--epochs n] [--rate r] [-k scale] [--threads n] file..." << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+	Bitboard::Precalculate();
+	Zobrist::Precalculate();
+	std::string output = "weights.txt", weightsPath;
+	int epochs = DefaultEpochs;
+	double rate = 1;
+	threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "-o" && hasValue) output = argv[++i];
+		else if (arg == "--weights" && hasValue) weightsPath = argv[++i];
+		else if (arg == "--epochs" && hasValue) epochs = std::atoi(argv[++i]);
+		else if (arg == "--rate" && hasValue) rate = std::atof(argv[++i]);
+		else if (arg == "-k" && hasValue) scale = std::atof(argv[++i]);
+		else if (arg == "--threads" && hasValue) threads = std::max(1, std::atoi(argv[++i]));
+		else if (arg[0] != '-') paths.push_back(arg);
+		else {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (paths.empty() || epochs < 0 || rate <= 0) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (!weightsPath.empty() && !EvalParams::Load(weightsPath)) {
+		std::cerr << "Can't load weights from " << weightsPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned long skipped = 0, mismatches = 0;
+	for (std::vector<std::string>::iterator pathItr = paths.begin(); pathItr != paths.end(); pathItr++) {
+		if (!loadFile(*pathItr, skipped, mismatches)) {
+			std::cerr << "Can't open " << *pathItr << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if (positions.size() == 0) {
+		std::cerr << "No positions to tune on" << std::endl;
+		return EXIT_FAILURE;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Positions: " << positions.size() << " (" << positions.params.size() / positions.size() << " terms each on average, "
+			  << skipped << " lines skipped) in " << seconds << " s" << std::endl;
+	// A mismatch means the terms have fallen out of step with Minimax::Eval, so the weights would be tuned for the wrong evaluation.
+	if (mismatches > 0) std::cerr << "Warning: " << mismatches << " positions evaluate differently from Minimax::Eval" << std::endl;
+	weights.assign(EvalParams::Weights, EvalParams::Weights + EvalParams::NUM_PARAMS);
+	if (scale == 0) fitScale();
+	std::cout << "Scale: " << scale << std::endl;
+	std::vector<double> gradient, mean(EvalParams::NUM_PARAMS, 0), variance(EvalParams::NUM_PARAMS, 0);
+	start = std::chrono::steady_clock::now();
+	for (int epoch = 1; epoch <= epochs; epoch++) {
+		double error = evaluate(&gradient);
+		// Adam: each weight moves by about the rate, in the direction of its average gradient, scaled down where the gradient is noisy.
+		for (int param = 0; param < EvalParams::NUM_PARAMS; param++) {
+			mean[param] = Beta1 * mean[param] + (1 - Beta1) * gradient[param];
+			variance[param] = Beta2 * variance[param] + (1 - Beta2) * gradient[param] * gradient[param];
+			double meanEstimate = mean[param] / (1 - std::pow(Beta1, epoch));
+			double varianceEstimate = variance[param] / (1 - std::pow(Beta2, epoch));
+			weights[param] -= (float)(rate * meanEstimate / (std::sqrt(varianceEstimate) + Epsilon));
+		}
+		if (epoch == 1 || epoch % ReportInterval == 0 || epoch == epochs) {
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cout << "Epoch " << epoch << ": error " << error << ", " << seconds << " s" << std::endl;
+			if (!saveWeights(output)) {
+				std::cerr << "Can't write " << output << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	if (epochs == 0) std::cout << "Error: " << evaluate(0) << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,15 @@
+#include <cstdlib>
+#include <iostream>
+#include "bitboard.hpp"
+#include "uci.hpp"
+#include "zobrist.hpp"
+using namespace ChessProject;
+
+// The headless engine. Speaks UCI over stdin/stdout, and doesn't depend on GTK.
+int main() {
+	Bitboard::Precalculate();
+	Zobrist::Precalculate();
+	Uci uci;
+	uci.loop(std::cin, std::cout);
+	return EXIT_SUCCESS;
+}